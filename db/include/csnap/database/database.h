@@ -5,9 +5,12 @@
 #ifndef CSNAP_DATABASE_H
 #define CSNAP_DATABASE_H
 
+#include <chrono>
 #include <filesystem>
+#include <memory>
 
 typedef struct sqlite3 sqlite3;
+typedef struct sqlite3_stmt sqlite3_stmt;
 
 namespace csnap
 {
@@ -21,11 +24,15 @@ namespace csnap
  * 
  * The Database class automatically closes the connection (if any) 
  * upon destruction.
+ * 
+ * The class also maintains a cache of prepared statements, keyed by their 
+ * SQL text, so that frequently executed queries are only compiled once.
+ * The cache is used by sql::Statement and is thread-safe.
  */
 class Database
 {
 public:
-  Database() = default;
+  Database();
   Database(const Database&) = delete;
   Database(Database&& other);
   ~Database();
@@ -34,17 +41,35 @@ public:
 
   bool good() const;
 
+  std::filesystem::path path() const;
+
   bool open(const std::filesystem::path& dbPath);
 
   void create(const std::filesystem::path& dbPath);
 
   void close();
 
+  void setBusyTimeout(std::chrono::milliseconds timeout);
+
+  sqlite3_stmt* acquireStatement(const char* query);
+  void releaseStatement(sqlite3_stmt* stmt);
+
+  struct StatementCacheStats
+  {
+    size_t hits = 0;
+    size_t misses = 0;
+  };
+
+  StatementCacheStats statementCacheStats() const;
+
   Database& operator=(const Database&) = delete;
   Database& operator=(Database&& other);
 
 private:
+  struct StatementCache;
+
   sqlite3* m_database = nullptr;
+  std::unique_ptr<StatementCache> m_statement_cache;
 };
 
 } // namespace csnap
@@ -0,0 +1,97 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#ifndef CSNAP_PENDINGDATA_H
+#define CSNAP_PENDINGDATA_H
+
+#include "csnap/model/file.h"
+#include "csnap/model/include.h"
+#include "csnap/model/reference.h"
+#include "csnap/model/symbol.h"
+#include "csnap/model/translationunit.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace csnap
+{
+
+/**
+ * \brief data added to a snapshot that has yet to be written into the database
+ * 
+ * The data is self-contained (files are stored by value) so that it can be 
+ * written by another thread while the snapshot keeps being modified.
+ * 
+ * \sa Snapshot::takePendingData(), Snapshot::write().
+ */
+struct PendingData
+{
+  /**
+   * \brief the properties that have yet to be written into the database 
+   */
+  std::map<std::string, std::string> properties;
+
+  /**
+   * \brief files that have yet to be written into the database
+   */
+  std::vector<File> files;
+
+  /**
+   * \brief ids of translation units that have yet to be written into the database
+   */
+  std::vector<TranslationUnit*> translation_units;
+
+  /**
+   * \brief translation units whose parsing and indexing times have yet to be written into the database
+   */
+  std::vector<TranslationUnit*> translation_unit_timings;
+
+  /**
+   * \brief serialized ASTs of translation units that have yet to be written into the database
+   */
+  std::map<TranslationUnit*, std::string> asts;
+
+  /**
+   * \brief include directives that have yet to be written into the database
+   */
+  std::map<TranslationUnit*, std::vector<Include>> includes;
+
+  /**
+   * \brief pointers to symbols that have yet to be written into the database
+   */
+  std::vector<std::shared_ptr<Symbol>> symbols;
+
+  /**
+   * \brief the list of base classes that have yet to be written into the database
+   */
+  std::map<SymbolId, std::vector<BaseClass>> bases;
+
+  std::vector<SymbolReference> symbol_references;
+
+  size_t rowCount() const;
+};
+
+/**
+ * \brief returns the number of rows that writing the data will insert
+ * 
+ * This is an approximation, mostly used to decide when the data should be written.
+ */
+inline size_t PendingData::rowCount() const
+{
+  size_t n = properties.size() + files.size() + translation_units.size() + translation_unit_timings.size() + asts.size() + symbols.size() + symbol_references.size();
+
+  for (const auto& p : includes)
+    n += 2 * p.second.size();
+
+  for (const auto& p : bases)
+    n += p.second.size();
+
+  return n;
+}
+
+} // namespace csnap
+
+#endif // CSNAP_PENDINGDATA_H
@@ -0,0 +1,48 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#ifndef CSNAP_REFERENCEENUMERATOR_H
+#define CSNAP_REFERENCEENUMERATOR_H
+
+#include "sql.h"
+
+#include "csnap/model/reference.h"
+
+namespace csnap
+{
+
+class Snapshot;
+
+/**
+ * \brief helper class for enumerating all symbol references in a snapshot
+ * 
+ * References are enumerated ordered by symbol, then by file and 
+ * line, so that all the references to a given symbol are 
+ * enumerated consecutively.
+ */
+class SymbolReferenceEnumerator
+{
+public:
+  Database& database;
+
+  /**
+   * \brief the reference that was last loaded
+   * 
+   * The reference is only valid after a successful call to next().
+   */
+  SymbolReference reference;
+
+protected:
+  sql::Statement m_query;
+
+public:
+  explicit SymbolReferenceEnumerator(Database& db);
+  explicit SymbolReferenceEnumerator(const Snapshot& s);
+
+  bool next();
+};
+
+} // namespace csnap
+
+#endif // CSNAP_REFERENCEENUMERATOR_H
@@ -14,9 +14,11 @@
 #include "csnap/model/reference.h"
 #include "csnap/model/symbolcache.h"
 
+#include <chrono>
 #include <filesystem>
 #include <map>
 #include <memory>
+#include <set>
 #include <utility>
 
 namespace csnap
@@ -25,6 +27,7 @@ namespace csnap
 struct PendingData;
 
 class SymbolLoader;
+class SymbolTable;
 
 /**
  * \brief provides a snapshot of a C++ program
@@ -59,13 +62,19 @@ public:
   File* findFile(const std::string& path) const;
   const FileList& files() const;
   void addFilesContent();
+  void addFilesContent(const std::vector<File*>& files);
+  std::vector<File*> listModifiedFiles() const;
   std::shared_ptr<FileContent> getFileContent(FileId f);
+  FileContentCache& fileContentCache();
 
   void addTranslationUnits(const std::vector<FileId>& file_ids, program::CompileOptions opts);
   TranslationUnit* findTranslationUnit(File* file) const;
   TranslationUnit* getTranslationUnit(TranslationUnitId id) const;
   const TranslationUnitList& translationUnits() const;
+  void setTranslationUnitTimings(TranslationUnit* tu, std::chrono::milliseconds parsing, std::chrono::milliseconds indexing);
   void addTranslationUnitSerializedAst(TranslationUnit* tu, const std::filesystem::path& astfile);
+  std::map<TranslationUnitId, std::set<FileId>> listTranslationUnitDependencies() const;
+  void removeIndexingResults(const std::vector<TranslationUnit*>& units, const std::set<FileId>& files);
 
   void addIncludes(const std::vector<Include>& includes, TranslationUnit* tu = nullptr);
   std::vector<Include> listIncludesInFile(FileId f) const;
@@ -76,6 +85,7 @@ public:
   std::map<SymbolId, std::shared_ptr<Symbol>> loadSymbols(const std::set<SymbolId>& ids);
   std::pair<size_t, size_t> loadSymbols(const std::set<SymbolId>& ids, std::map<SymbolId, std::shared_ptr<Symbol>>& outmap);
   SymbolCache& symbolCache();
+  SymbolTable loadSymbolTable() const;
 
   void addBases(SymbolId symid, const std::vector<BaseClass>& bases);
   std::vector<BaseClass> listBaseClasses(SymbolId symid) const;
@@ -86,7 +96,16 @@ public:
   std::vector<SymbolReference> listReferencesInFile(FileId file);
 
   bool hasPendingData() const;
+  size_t pendingRowCount() const;
   void writePendingData();
+  std::unique_ptr<PendingData> takePendingData();
+  void write(const PendingData& data);
+
+  void beginBulkLoad();
+  void endBulkLoad();
+
+  void upgrade();
+  void createIndexes();
 
 protected:
   PendingData& pendingData();
@@ -98,6 +117,13 @@ private:
   FileContentCache m_filecontent_cache;
   SymbolCache m_symbol_cache;
   std::unique_ptr<PendingData> m_pending_data;
+  struct BulkLoadSettings
+  {
+    std::string journal_mode;
+    std::string synchronous;
+    std::string cache_size;
+  };
+  std::unique_ptr<BulkLoadSettings> m_bulk_load;
 };
 
 } // namespace csnap
@@ -9,7 +9,9 @@
 
 #include <sqlite3.h>
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace sql
 {
@@ -41,11 +43,14 @@ public:
   void bind(int n, const char* text);
   void bind(int n, std::string&& text);
   void bind(int n, int value);
+  void bind(int n, int64_t value);
   void bindBlob(int n, const std::string& bytes);
 
   bool nullColumn(int n) const;
   std::string column(int n) const;
+  std::string_view columnView(int n) const;
   int columnInt(int n) const;
+  int64_t columnInt64(int n) const;
 };
 
 inline Statement::Statement(Database& db)
@@ -72,10 +77,17 @@ inline Statement::~Statement()
   finalize();
 }
 
+/**
+ * \brief prepares the statement
+ * \param query  the SQL text
+ * 
+ * The statement is taken from the database's statement cache if possible.
+ */
 inline bool Statement::prepare(const char* query)
 {
-  int r = sqlite3_prepare_v2(m_database.sqliteHandle(), query, -1, &m_statement, nullptr);
-  return r == SQLITE_OK;
+  finalize();
+  m_statement = m_database.acquireStatement(query);
+  return m_statement != nullptr;
 }
 
 inline bool Statement::step()
@@ -89,9 +101,14 @@ inline void Statement::reset()
   sqlite3_reset(m_statement);
 }
 
+/**
+ * \brief releases the statement
+ * 
+ * The statement is given back to the database's statement cache.
+ */
 inline void Statement::finalize()
 {
-  sqlite3_finalize(m_statement);
+  m_database.releaseStatement(m_statement);
   m_statement = nullptr;
 }
 
@@ -125,6 +142,11 @@ inline void Statement::bind(int n, int value)
   sqlite3_bind_int(m_statement, n, value);
 }
 
+inline void Statement::bind(int n, int64_t value)
+{
+  sqlite3_bind_int64(m_statement, n, value);
+}
+
 inline void Statement::bindBlob(int n, const std::string& bytes)
 {
   sqlite3_bind_blob(m_statement, n, bytes.c_str(), (int)bytes.size(), nullptr);
@@ -140,11 +162,33 @@ inline std::string Statement::column(int n) const
   return std::string(reinterpret_cast<const char*>(sqlite3_column_text(m_statement, n)));
 }
 
+/**
+ * \brief returns a view of a text column
+ * \param n  the column index
+ * 
+ * The view is only valid until the next call to step() or reset().
+ * An empty view is returned for NULL values.
+ */
+inline std::string_view Statement::columnView(int n) const
+{
+  const unsigned char* text = sqlite3_column_text(m_statement, n);
+
+  if (!text)
+    return std::string_view();
+
+  return std::string_view(reinterpret_cast<const char*>(text), static_cast<size_t>(sqlite3_column_bytes(m_statement, n)));
+}
+
 inline int Statement::columnInt(int n) const
 {
   return sqlite3_column_int(m_statement, n);
 }
 
+inline int64_t Statement::columnInt64(int n) const
+{
+  return sqlite3_column_int64(m_statement, n);
+}
+
 /*********************************************/
 
 inline bool exec(Database& db, const std::string& query, std::string* error = nullptr)
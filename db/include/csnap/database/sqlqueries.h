@@ -9,10 +9,13 @@
 
 #include "csnap/model/fileid.h"
 #include "csnap/model/symbolid.h"
+#include "csnap/model/translationunitid.h"
 
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace csnap
@@ -31,6 +34,8 @@ struct CompileOptions;
 } // namespace program
 
 const char* db_init_statements();
+bool db_create_indexes(Database& db);
+void db_upgrade_schema(Database& db);
 
 void insert_info(Database& db, const std::string& key, const std::string& value);
 std::string select_info(Database& db, const std::string& key);
@@ -43,7 +48,9 @@ std::vector<SymbolId> select_symbold_id_from_base(Database& db, SymbolId base_id
 
 void insert_file(Database& db, const File& file);
 void insert_file_content(Database& db, const std::vector<File*>& files);
+void insert_file_content(Database& db, FileId file, const std::string& content, const std::string& hash);
 void insert_translationunit(Database& db, const std::vector<TranslationUnit*>& units);
+void insert_translationunit_timings(Database& db, const std::vector<TranslationUnit*>& units);
 void insert_translationunit_ast(Database& db, TranslationUnit* tu, const std::string& bytes);
 void insert_ppinclude(Database& db, const TranslationUnit& tu, const std::vector<Include>& includes);
 void insert_includes(Database& db, const std::vector<Include>& includes);
@@ -53,11 +60,23 @@ void insert_symbol_references(Database& db, const std::vector<SymbolReference>&
 void insert_base(Database& db, const std::map<SymbolId, std::vector<BaseClass>>& bases);
 
 std::vector<File> select_file(Database& db);
+std::map<FileId, std::string> select_hash_from_file(Database& db);
 std::string select_content_from_file(Database& db, FileId file);
 std::map<int, std::shared_ptr<program::CompileOptions>> select_compileoptions(Database& db);
 std::vector<TranslationUnit> select_translationunit(Database& db);
 
 std::vector<Include> select_from_include(Database& db, FileId file_id = {}, FileId included_file_id = {});
+std::map<TranslationUnitId, std::set<FileId>> select_included_file_id_from_ppinclude(Database& db);
+std::map<TranslationUnitId, std::vector<Include>> select_from_ppinclude(Database& db);
+
+std::map<FileId, size_t> select_count_from_symbolreference(Database& db);
+std::vector<std::pair<SymbolId, std::string>> select_usr_from_symbol(Database& db);
+std::vector<SymbolId> select_distinct_symbol_id_from_base(Database& db);
+
+void delete_from_ppinclude(Database& db, TranslationUnitId tu);
+void delete_from_include(Database& db, FileId file);
+void delete_from_base_defined_in(Database& db, FileId file);
+void delete_from_symbolreference(Database& db, FileId file);
 
 } // namespace csnap
 
@@ -9,6 +9,8 @@
 
 #include "csnap/model/symbol.h"
 
+#include <vector>
+
 namespace csnap
 {
 
@@ -41,6 +43,8 @@ public:
 
 /**
  * \brief helper class for enumerating symbols in a snapshot
+ * 
+ * Symbols are enumerated by increasing id.
  */
 class SymbolEnumerator
 {
@@ -64,6 +68,29 @@ public:
   bool next();
 };
 
+/**
+ * \brief helper class for loading many symbols at once
+ * 
+ * Symbols are fetched by batches of BatchSize ids, using a single 
+ * statement per batch.
+ */
+class SymbolBatchLoader
+{
+public:
+  Database& database;
+
+  static constexpr size_t BatchSize = 256;
+
+protected:
+  sql::Statement m_query;
+
+public:
+  explicit SymbolBatchLoader(Database& db);
+  explicit SymbolBatchLoader(const Snapshot& s);
+
+  std::vector<Symbol> read(const std::vector<SymbolId>& ids);
+};
+
 } // namespace csnap
 
 #endif // CSNAP_SYMBOLLOADER_H
@@ -8,13 +8,30 @@
 
 #include <cassert>
 #include <filesystem>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace csnap
 {
 
+struct Database::StatementCache
+{
+  std::mutex mutex;
+  // statements that are not currently in use, by SQL text
+  std::map<std::string, std::vector<sqlite3_stmt*>, std::less<>> statements;
+  Database::StatementCacheStats stats;
+};
+
+Database::Database() = default;
+
 Database::Database(Database&& other) :
-  m_database(other.m_database)
+  m_database(other.m_database),
+  m_statement_cache(std::move(other.m_statement_cache))
 {
   other.m_database = nullptr;
 }
@@ -41,6 +58,25 @@ bool Database::good() const
   return sqliteHandle() != nullptr;
 }
 
+/**
+ * \brief returns the path of the database file
+ * 
+ * An empty path is returned if there is no connection or if the 
+ * database is an in-memory or temporary database.
+ */
+std::filesystem::path Database::path() const
+{
+  if (!good())
+    return {};
+
+  const char* filename = sqlite3_db_filename(sqliteHandle(), "main");
+
+  if (!filename || *filename == '\0')
+    return {};
+
+  return std::filesystem::u8path(filename);
+}
+
 /**
  * \brief opens a connection to a database
  * \param dbPath  the path of the database
@@ -73,19 +109,144 @@ void Database::create(const std::filesystem::path& dbPath)
 
 /**
  * \brief close the connection, if any
+ * 
+ * The cached statements are finalized. 
+ * Statements that are still in use are finalized when they are released 
+ * (see releaseStatement()); the connection is only actually closed by 
+ * sqlite once the last of them is finalized.
  */
 void Database::close()
 {
   if (!good())
     return;
 
-  sqlite3_close(m_database);
+  if (m_statement_cache)
+  {
+    std::lock_guard lock{ m_statement_cache->mutex };
+
+    for (auto& p : m_statement_cache->statements)
+    {
+      for (sqlite3_stmt* stmt : p.second)
+        sqlite3_finalize(stmt);
+    }
+
+    m_statement_cache->statements.clear();
+  }
+
+  sqlite3_close_v2(m_database);
   m_database = nullptr;
 }
 
+/**
+ * \brief sets how long to wait for a lock held by another connection
+ * \param timeout  the maximum waiting time, zero to fail immediately
+ * 
+ * By default, an operation fails with SQLITE_BUSY as soon as the database 
+ * is locked; this is needed when several processes share the database 
+ * (e.g., the scan worker processes, see WorkerPool).
+ */
+void Database::setBusyTimeout(std::chrono::milliseconds timeout)
+{
+  if (good())
+    sqlite3_busy_timeout(m_database, static_cast<int>(timeout.count()));
+}
+
+/**
+ * \brief returns a prepared statement for a query
+ * \param query  the SQL text of the query
+ * \return the statement, or nullptr if the query could not be compiled
+ * 
+ * If a statement for \a query is available in the cache, it is returned; 
+ * otherwise a new statement is prepared.
+ * The statement must be given back with releaseStatement() once it is no 
+ * longer used.
+ */
+sqlite3_stmt* Database::acquireStatement(const char* query)
+{
+  if (!good())
+    return nullptr;
+
+  if (!m_statement_cache)
+    m_statement_cache = std::make_unique<StatementCache>();
+
+  {
+    std::lock_guard lock{ m_statement_cache->mutex };
+
+    auto it = m_statement_cache->statements.find(std::string_view(query));
+
+    if (it != m_statement_cache->statements.end() && !it->second.empty())
+    {
+      sqlite3_stmt* stmt = it->second.back();
+      it->second.pop_back();
+      ++m_statement_cache->stats.hits;
+      return stmt;
+    }
+
+    ++m_statement_cache->stats.misses;
+  }
+
+  sqlite3_stmt* stmt = nullptr;
+  sqlite3_prepare_v2(sqliteHandle(), query, -1, &stmt, nullptr);
+  return stmt;
+}
+
+/**
+ * \brief gives back a statement obtained with acquireStatement()
+ * \param stmt  the statement
+ * 
+ * The statement is reset, its bindings are cleared and it is put 
+ * in the cache for later use.
+ * If the connection was closed in the meantime, the statement is finalized.
+ */
+void Database::releaseStatement(sqlite3_stmt* stmt)
+{
+  if (!stmt)
+    return;
+
+  if (!good() || !m_statement_cache)
+  {
+    sqlite3_finalize(stmt);
+    return;
+  }
+
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+
+  // we do not need to keep many copies of the same statement, 
+  // more than a few are only needed if a query is used recursively 
+  // or by several threads.
+  constexpr size_t max_copies = 8;
+
+  {
+    std::lock_guard lock{ m_statement_cache->mutex };
+    std::vector<sqlite3_stmt*>& list = m_statement_cache->statements[sqlite3_sql(stmt)];
+
+    if (list.size() < max_copies)
+    {
+      list.push_back(stmt);
+      return;
+    }
+  }
+
+  sqlite3_finalize(stmt);
+}
+
+/**
+ * \brief returns the number of hits and misses of the statement cache
+ */
+Database::StatementCacheStats Database::statementCacheStats() const
+{
+  if (!m_statement_cache)
+    return {};
+
+  std::lock_guard lock{ m_statement_cache->mutex };
+  return m_statement_cache->stats;
+}
+
 Database& Database::operator=(Database&& other)
 {
   m_database = other.m_database;
+  m_statement_cache = std::move(other.m_statement_cache);
   other.m_database = nullptr;
   return *this;
 }
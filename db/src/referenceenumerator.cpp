@@ -0,0 +1,47 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#include "referenceenumerator.h"
+
+#include "snapshot.h"
+
+namespace csnap
+{
+
+SymbolReferenceEnumerator::SymbolReferenceEnumerator(Database& db) :
+  database(db),
+  m_query(db, "SELECT symbol_id, file_id, line, col, parent_symbol_id, flags FROM symbolreference ORDER BY symbol_id, file_id, line, col")
+{
+
+}
+
+/**
+ * \brief constructs a reference enumerator on a snapshot
+ * \param s  the snapshot
+ */
+SymbolReferenceEnumerator::SymbolReferenceEnumerator(const Snapshot& s) : SymbolReferenceEnumerator(s.database())
+{
+
+}
+
+/**
+ * \brief load the next reference
+ * \return true if a reference was loaded, false if the end has been reached
+ */
+bool SymbolReferenceEnumerator::next()
+{
+  if (!m_query.step())
+    return false;
+
+  reference.symbol_id = SymbolId(m_query.columnInt64(0));
+  reference.file_id = FileId(m_query.columnInt64(1));
+  reference.line = m_query.columnInt(2);
+  reference.col = m_query.columnInt(3);
+  reference.parent_symbol_id = m_query.nullColumn(4) ? SymbolId() : SymbolId(m_query.columnInt64(4));
+  reference.flags = m_query.columnInt(5);
+
+  return true;
+}
+
+} // namespace csnap
@@ -4,11 +4,15 @@
 
 #include "snapshot.h"
 
+#include "pendingdata.h"
 #include "sql.h"
 #include "sqlqueries.h"
 #include "symbolloader.h"
 #include "transaction.h"
 
+#include "csnap/model/hash.h"
+#include "csnap/model/symboltable.h"
+
 #include <algorithm>
 #include <fstream>
 #include <map>
@@ -17,47 +21,14 @@
 namespace csnap
 {
 
-struct PendingData
-{
-  /**
-   * \brief the properties that have yet to be written into the database 
-   */
-  std::map<std::string, std::string> properties;
-
-  /**
-   * \brief ids of files that have yet to be written into the database
-   */
-  std::vector<FileId> files;
-
-  /**
-   * \brief ids of translation units that have yet to be written into the database
-   */
-  std::vector<TranslationUnit*> translation_units;
-
-  /**
-   * \brief include directives that have yet to be written into the database
-   */
-  std::map<TranslationUnit*, std::vector<Include>> includes;
-
-  /**
-   * \brief pointers to symbols that have yet to be written into the database
-   */
-  std::vector<std::shared_ptr<Symbol>> symbols;
-
-  /**
-   * \brief the list of base classes that have yet to be written into the database
-   */
-  std::map<SymbolId, std::vector<BaseClass>> bases;
-
-  std::vector<SymbolReference> symbol_references;
-};
-
 Snapshot::Snapshot(Snapshot&&) = default;
 
 Snapshot::~Snapshot()
 {
   if (hasPendingData())
     writePendingData();
+
+  endBulkLoad();
 }
 
 Snapshot::Snapshot(Database db) : 
@@ -97,6 +68,9 @@ Database& Snapshot::database() const
 /**
  * \brief opens a snapshot
  * \param p  the path of the snapshot
+ * 
+ * The database is not modified; snapshots created by an older version 
+ * of csnap can be brought up to date with upgrade().
  */
 Snapshot Snapshot::open(const std::filesystem::path& p)
 {
@@ -124,9 +98,14 @@ Snapshot Snapshot::create(const std::filesystem::path& p)
  * \brief sets a property of the snapshot
  * \param key    the property name
  * \param value  its value
+ * 
+ * Nothing is written if the property already has this value.
  */
 void Snapshot::setProperty(const std::string& key, const std::string& value)
 {
+  if (property(key) == value)
+    return;
+
   pendingData().properties[key] = value;
 }
 
@@ -184,7 +163,7 @@ File* Snapshot::addFile(File f)
 {
   File* file = m_files.add(getCanonicalPath(std::move(f.path)));
 
-  pendingData().files.push_back(FileId(file->id));
+  pendingData().files.push_back(*file);
 
   return file;
 }
@@ -192,8 +171,8 @@ File* Snapshot::addFile(File f)
 void Snapshot::addFile(std::unique_ptr<File> f)
 {
   f->path = getCanonicalPath(std::move(f->path));
-  FileId id = m_files.add(std::move(f))->id;
-  pendingData().files.push_back(id);
+  File* file = m_files.add(std::move(f));
+  pendingData().files.push_back(*file);
 }
 
 /**
@@ -258,6 +237,52 @@ void Snapshot::addFilesContent()
   insert_file_content(*m_database, files().all());
 }
 
+/**
+ * \brief saves a copy of some files in the database
+ * \param files  the files to copy
+ * 
+ * Any previously saved copy of the files is replaced.
+ */
+void Snapshot::addFilesContent(const std::vector<File*>& files)
+{
+  m_filecontent_cache.clear();
+  sql::Transaction transaction{ *m_database };
+  insert_file_content(*m_database, files);
+}
+
+/**
+ * \brief lists the files whose content changed since they were saved in the snapshot
+ * 
+ * The content of each file on disk is hashed and compared to the hash 
+ * stored in the database by addFilesContent().
+ * A file is considered modified if it was deleted, or if it exists but 
+ * its content was never saved in the snapshot.
+ */
+std::vector<File*> Snapshot::listModifiedFiles() const
+{
+  std::map<FileId, std::string> hashes = select_hash_from_file(*m_database);
+  std::vector<File*> result;
+
+  for (File* f : files().all())
+  {
+    auto it = hashes.find(f->id);
+    std::filesystem::path filepath{ f->path };
+
+    if (!std::filesystem::exists(filepath))
+    {
+      if (it != hashes.end())
+        result.push_back(f);
+
+      continue;
+    }
+
+    if (it == hashes.end() || it->second != content_hash(readFile(filepath)))
+      result.push_back(f);
+  }
+
+  return result;
+}
+
 /**
  * \brief retrieves a copy of a file
  * \param f  the id of the file
@@ -289,6 +314,17 @@ std::shared_ptr<FileContent> Snapshot::getFileContent(FileId f)
   return result;
 }
 
+/**
+ * \brief returns the file content cache
+ * 
+ * This cache is used by getFileContent() to avoid reloading the 
+ * content of files from the database.
+ */
+FileContentCache& Snapshot::fileContentCache()
+{
+  return m_filecontent_cache;
+}
+
 void Snapshot::addTranslationUnits(const std::vector<FileId>& file_ids, program::CompileOptions opts)
 {
   auto optsptr = std::make_shared<program::CompileOptions>(opts);
@@ -333,11 +369,72 @@ const TranslationUnitList& Snapshot::translationUnits() const
   return m_translationunits;
 }
 
+/**
+ * \brief records the time spent parsing and indexing a translation unit
+ * \param tu        the translation unit
+ * \param parsing   the parsing time
+ * \param indexing  the indexing time
+ * 
+ * The times are used to schedule the translation units of the next scan 
+ * (see Scanner).
+ */
+void Snapshot::setTranslationUnitTimings(TranslationUnit* tu, std::chrono::milliseconds parsing, std::chrono::milliseconds indexing)
+{
+  tu->parsing_time = parsing;
+  tu->indexing_time = indexing;
+  pendingData().translation_unit_timings.push_back(tu);
+}
+
+/**
+ * \brief adds the serialized AST of a translation unit to the snapshot
+ * \param tu       the translation unit
+ * \param astfile  the file in which the AST was saved
+ * 
+ * The content of \a astfile is read immediately, so the file can be removed 
+ * once this function returns; it is written into the database along with 
+ * the other pending data.
+ */
 void Snapshot::addTranslationUnitSerializedAst(TranslationUnit* tu, const std::filesystem::path& astfile)
 {
-  std::string bytes = readFile(astfile);
+  pendingData().asts[tu] = readFile(astfile);
+}
 
-  insert_translationunit_ast(*m_database, tu, bytes);
+/**
+ * \brief returns the files on which each translation unit depends
+ * 
+ * The dependencies of a translation unit are the files it includes, 
+ * directly or indirectly; the source file of the translation unit 
+ * is not part of the list.
+ */
+std::map<TranslationUnitId, std::set<FileId>> Snapshot::listTranslationUnitDependencies() const
+{
+  return select_included_file_id_from_ppinclude(*m_database);
+}
+
+/**
+ * \brief removes previous indexing results from the database
+ * \param units  translation units which preprocessing information is removed
+ * \param files  files which #include, symbol references and base classes are removed
+ * 
+ * This function is used before re-indexing translation units; 
+ * note that symbols are not removed.
+ */
+void Snapshot::removeIndexingResults(const std::vector<TranslationUnit*>& units, const std::set<FileId>& files)
+{
+  sql::Transaction transaction{ *m_database };
+
+  for (TranslationUnit* tu : units)
+  {
+    delete_from_ppinclude(*m_database, tu->id);
+  }
+
+  for (FileId f : files)
+  {
+    delete_from_include(*m_database, f);
+    // must be done before the symbol references are removed
+    delete_from_base_defined_in(*m_database, f);
+    delete_from_symbolreference(*m_database, f);
+  }
 }
 
 /**
@@ -429,14 +526,17 @@ std::map<SymbolId, std::shared_ptr<Symbol>> Snapshot::loadSymbols(const std::set
  * \param ids     ids of the symbol to retrieve
  * \param outmap  the output map in which the results are written
  * \return the pair (number of symbol loaded from the database, number of symbol found in the cache)
+ * 
+ * Symbols that are not in the cache are loaded by batches (see SymbolBatchLoader) 
+ * and inserted into the cache.
  */
 std::pair<size_t, size_t> Snapshot::loadSymbols(const std::set<SymbolId>& ids, std::map<SymbolId, std::shared_ptr<Symbol>>& outmap)
 {
-  SymbolLoader loader{ *m_database };
-
   size_t loaded = 0;
   size_t cache = 0;
 
+  std::vector<SymbolId> missing;
+
   for (SymbolId id : ids)
   {
     if (std::shared_ptr<Symbol> symbol = symbolCache().find(id))
@@ -444,10 +544,22 @@ std::pair<size_t, size_t> Snapshot::loadSymbols(const std::set<SymbolId>& ids, s
       ++cache;
       outmap[symbol->id] = symbol;
     }
-    else if(loader.read(id))
+    else
     {
+      missing.push_back(id);
+    }
+  }
+
+  if (!missing.empty())
+  {
+    SymbolBatchLoader loader{ *m_database };
+
+    for (Symbol& s : loader.read(missing))
+    {
+      auto symbol = std::make_shared<Symbol>(std::move(s));
+      symbolCache().insert(symbol);
+      outmap[symbol->id] = symbol;
       ++loaded;
-      outmap[id] = std::make_shared<Symbol>(std::move(loader.symbol));
     }
   }
 
@@ -485,6 +597,33 @@ std::vector<SymbolReference> Snapshot::listReferencesInFile(FileId file)
   return select_symbolreference(*m_database, file);
 }
 
+/**
+ * \brief loads all the symbols of the snapshot
+ * 
+ * The whole symbol table is read in a single pass.
+ * The returned table does not reflect symbols that have not yet 
+ * been written to the database (see writePendingData()).
+ */
+SymbolTable Snapshot::loadSymbolTable() const
+{
+  SymbolTable table;
+
+  sql::Statement stmt{ *m_database, "SELECT id, what, parent, name, usr, displayname, flags FROM symbol" };
+
+  while (stmt.step())
+  {
+    table.add(SymbolId(stmt.columnInt64(0)), 
+      static_cast<Whatsit>(stmt.columnInt(1)), 
+      stmt.columnInt(6),
+      stmt.nullColumn(2) ? SymbolId() : SymbolId(stmt.columnInt64(2)),
+      stmt.columnView(3), 
+      stmt.columnView(4), 
+      stmt.columnView(5));
+  }
+
+  return table;
+}
+
 /**
  * \brief returns the symbol cache
  * 
@@ -536,26 +675,69 @@ bool Snapshot::hasPendingData() const
   return m_pending_data != nullptr;
 }
 
+/**
+ * \brief returns an estimate of the number of rows that have yet to be written
+ */
+size_t Snapshot::pendingRowCount() const
+{
+  return hasPendingData() ? m_pending_data->rowCount() : 0;
+}
+
+/**
+ * \brief writes all pending data into the database
+ */
 void Snapshot::writePendingData()
 {
   if (!hasPendingData())
     return;
 
+  std::unique_ptr<PendingData> data = takePendingData();
+  write(*data);
+}
+
+/**
+ * \brief removes the pending data from the snapshot
+ * 
+ * The caller becomes responsible for writing the data with write().
+ * This function returns nullptr if there is no pending data.
+ */
+std::unique_ptr<PendingData> Snapshot::takePendingData()
+{
+  return std::move(m_pending_data);
+}
+
+/**
+ * \brief writes data into the database
+ * \param data  the data to write
+ * 
+ * The data is written in a single transaction.
+ * This function may be called from another thread than the one modifying the 
+ * snapshot (see SnapshotWriter) as it only uses the database connection.
+ */
+void Snapshot::write(const PendingData& data)
+{
   sql::Transaction transaction{ *m_database };
 
-  for (const std::pair<const std::string, std::string>& p : m_pending_data->properties)
+  for (const std::pair<const std::string, std::string>& p : data.properties)
   {
     insert_info(*m_database, p.first, p.second);
   }
 
-  for (FileId f : m_pending_data->files)
+  for (const File& f : data.files)
   {
-    insert_file(*m_database, *m_files.get(f));
+    insert_file(*m_database, f);
   }
 
-  insert_translationunit(*m_database, m_pending_data->translation_units);
+  insert_translationunit(*m_database, data.translation_units);
+
+  insert_translationunit_timings(*m_database, data.translation_unit_timings);
+
+  for (const std::pair<TranslationUnit* const, std::string>& p : data.asts)
+  {
+    insert_translationunit_ast(*m_database, p.first, p.second);
+  }
 
-  for (const std::pair<TranslationUnit* const, std::vector<Include>>& p : m_pending_data->includes)
+  for (const std::pair<TranslationUnit* const, std::vector<Include>>& p : data.includes)
   {
     if (p.first)
     {
@@ -565,13 +747,93 @@ void Snapshot::writePendingData()
     insert_includes(*m_database, p.second);
   }
 
-  insert_symbol(*m_database, m_pending_data->symbols);
+  insert_symbol(*m_database, data.symbols);
+
+  insert_base(*m_database, data.bases);
+
+  insert_symbol_references(*m_database, data.symbol_references);
+}
 
-  insert_base(*m_database, m_pending_data->bases);
+/**
+ * \brief configures the database for inserting a large amount of data
+ * 
+ * This disables the synchronization of the database file with the disk 
+ * and keeps the rollback journal in memory; if the program crashes during 
+ * the bulk load, the database may be corrupted.
+ * The previous settings are restored by endBulkLoad().
+ */
+void Snapshot::beginBulkLoad()
+{
+  if (m_bulk_load)
+    return;
 
-  insert_symbol_references(*m_database, m_pending_data->symbol_references);
+  auto read_pragma = [this](const char* name) -> std::string {
+    sql::Statement stmt{ *m_database, (std::string("PRAGMA ") + name).c_str() };
+    return stmt.step() ? stmt.column(0) : std::string();
+  };
+
+  m_bulk_load = std::make_unique<BulkLoadSettings>();
+  m_bulk_load->journal_mode = read_pragma("journal_mode");
+  m_bulk_load->synchronous = read_pragma("synchronous");
+  m_bulk_load->cache_size = read_pragma("cache_size");
+
+  sql::exec(*m_database, "PRAGMA journal_mode = MEMORY");
+  sql::exec(*m_database, "PRAGMA synchronous = OFF");
+  sql::exec(*m_database, "PRAGMA cache_size = -262144"); // 256MB
+  sql::exec(*m_database, "PRAGMA temp_store = MEMORY");
+}
+
+/**
+ * \brief restores the database settings modified by beginBulkLoad()
+ */
+void Snapshot::endBulkLoad()
+{
+  if (!m_bulk_load)
+    return;
+
+  writePendingData();
+
+  if (!m_bulk_load->journal_mode.empty())
+    sql::exec(*m_database, "PRAGMA journal_mode = " + m_bulk_load->journal_mode);
+
+  if (!m_bulk_load->synchronous.empty())
+    sql::exec(*m_database, "PRAGMA synchronous = " + m_bulk_load->synchronous);
+
+  if (!m_bulk_load->cache_size.empty())
+    sql::exec(*m_database, "PRAGMA cache_size = " + m_bulk_load->cache_size);
+
+  sql::exec(*m_database, "PRAGMA temp_store = DEFAULT");
+
+  m_bulk_load.reset();
+}
+
+/**
+ * \brief upgrades a snapshot created by an older version of csnap
+ * 
+ * Missing columns and indexes are added to the database.
+ * This should only be called by the process that owns the snapshot, 
+ * before any other connection to the database is opened (e.g., those 
+ * of the exporter threads or of the worker processes).
+ */
+void Snapshot::upgrade()
+{
+  db_upgrade_schema(*m_database);
+  createIndexes();
+}
+
+/**
+ * \brief creates the indexes of the database
+ * 
+ * Indexes make queries on the snapshot much faster but slow down insertions;
+ * this function should be called once the snapshot has been filled.
+ * Pending data is written before the indexes are created.
+ */
+void Snapshot::createIndexes()
+{
+  writePendingData();
 
-  m_pending_data.reset();
+  if (!db_create_indexes(*m_database))
+    throw std::runtime_error("failed to create snapshot indexes");
 }
 
 PendingData& Snapshot::pendingData()
@@ -8,6 +8,7 @@
 #include "sql.h"
 
 #include "csnap/model/file.h"
+#include "csnap/model/hash.h"
 #include "csnap/model/include.h"
 #include "csnap/model/reference.h"
 #include "csnap/model/symbol.h"
@@ -31,7 +32,8 @@ CREATE TABLE IF NOT EXISTS "info" (
 CREATE TABLE IF NOT EXISTS "file" (
   "id"      INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT UNIQUE,
   "path"    TEXT NOT NULL,
-  "content" TEXT
+  "content" TEXT,
+  "hash"    TEXT
 );
 
 CREATE TABLE "compileoptions" (
@@ -45,6 +47,8 @@ CREATE TABLE IF NOT EXISTS "translationunit" (
   "file_id"                        INTEGER NOT NULL,
   "compileoptions_id"              INTEGER,
   "ast"                            BLOB,
+  "parsing_time"                   INTEGER,
+  "indexing_time"                  INTEGER,
   FOREIGN KEY("file_id")           REFERENCES "file"("id"),
   FOREIGN KEY("compileoptions_id") REFERENCES "compileoptions"("id")
 );
@@ -140,6 +144,22 @@ CREATE VIEW symboldefinition (symbol_id, file_id, line, col, flags) AS
 COMMIT;
 )";
 
+// The indexes are created once the database has been filled (see db_create_indexes()) 
+// as maintaining them while inserting rows would slow down the scan.
+static const char* SQL_CREATE_INDEXES = R"(
+BEGIN TRANSACTION;
+
+CREATE INDEX IF NOT EXISTS "symbolreference_file_idx" ON "symbolreference" ("file_id", "line", "col");
+CREATE INDEX IF NOT EXISTS "symbolreference_symbol_idx" ON "symbolreference" ("symbol_id", "file_id", "line");
+CREATE INDEX IF NOT EXISTS "base_symbol_idx" ON "base" ("symbol_id");
+CREATE INDEX IF NOT EXISTS "base_base_idx" ON "base" ("base_id");
+CREATE INDEX IF NOT EXISTS "include_included_file_idx" ON "include" ("included_file_id");
+CREATE INDEX IF NOT EXISTS "ppinclude_translationunit_idx" ON "ppinclude" ("translationunit_id");
+CREATE INDEX IF NOT EXISTS "symbol_usr_idx" ON "symbol" ("usr");
+
+COMMIT;
+)";
+
 template<typename T, typename F>
 std::vector<T> read_vector(sql::Statement& stmt, F&& func)
 {
@@ -158,42 +178,82 @@ const char* db_init_statements()
   return SQL_CREATE_STATEMENTS;
 }
 
-void insert_info(Database& db, const std::string& key, const std::string& value)
+/**
+ * \brief creates the secondary indexes of the database
+ * 
+ * Indexes that already exist are not created again.
+ */
+bool db_create_indexes(Database& db)
 {
-  sqlite3_stmt* stmt = nullptr;
+  return sql::exec(db, SQL_CREATE_INDEXES);
+}
 
-  sqlite3_prepare_v2(db.sqliteHandle(),
-    "INSERT OR REPLACE INTO info (key, value) VALUES (?,?)",
-    -1, &stmt, nullptr);
+static bool has_column(Database& db, const char* table, const char* column)
+{
+  sql::Statement stmt{ db, (std::string("PRAGMA table_info(") + table + ")").c_str() };
 
-  sqlite3_bind_text(stmt, 1, key.c_str(), -1, nullptr);
-  sqlite3_bind_text(stmt, 2, value.c_str(), -1, nullptr);
+  while (stmt.step())
+  {
+    if (stmt.column(1) == column)
+      return true;
+  }
 
-  sqlite3_step(stmt);
+  return false;
+}
 
-  sqlite3_finalize(stmt);
+/**
+ * \brief upgrades the schema of a database created by an older version of csnap
+ * 
+ * Columns that were added to the schema over time are added to the 
+ * existing tables (with NULL values).
+ * This modifies the database and must only be called from the connection 
+ * that owns the snapshot (see Snapshot::upgrade()); the select functions 
+ * accept databases that have not been upgraded.
+ */
+void db_upgrade_schema(Database& db)
+{
+  if (!has_column(db, "file", "hash"))
+    sql::exec(db, "ALTER TABLE file ADD COLUMN hash TEXT");
+
+  if (!has_column(db, "translationunit", "parsing_time"))
+  {
+    sql::exec(db, "ALTER TABLE translationunit ADD COLUMN parsing_time INTEGER");
+    sql::exec(db, "ALTER TABLE translationunit ADD COLUMN indexing_time INTEGER");
+  }
 }
 
-std::string select_info(Database& db, const std::string& key)
+/**
+ * \brief sets the value of a key in the info table
+ * 
+ * The table has no unique constraint on the key, so any previous row 
+ * with the same key is deleted before the new value is inserted.
+ */
+void insert_info(Database& db, const std::string& key, const std::string& value)
 {
-  sqlite3_stmt* stmt = nullptr;
+  {
+    sql::Statement stmt{ db, "DELETE FROM info WHERE key = ?" };
+    stmt.bind(1, key.c_str());
+    stmt.step();
+  }
 
-  sqlite3_prepare_v2(db.sqliteHandle(),
-    "SELECT value FROM info WHERE key = ?",
-    -1, &stmt, nullptr);
+  sql::Statement stmt{ db, "INSERT INTO info (key, value) VALUES (?,?)" };
 
-  sqlite3_bind_text(stmt, 1, key.c_str(), -1, nullptr);
+  stmt.bind(1, key.c_str());
+  stmt.bind(2, value.c_str());
 
-  std::string result;
+  stmt.step();
+}
 
-  if (sqlite3_step(stmt) == SQLITE_ROW)
-  {
-    result = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-  }
+std::string select_info(Database& db, const std::string& key)
+{
+  sql::Statement stmt{ db, "SELECT value FROM info WHERE key = ? ORDER BY id DESC LIMIT 1" };
 
-  sqlite3_finalize(stmt);
+  stmt.bind(1, key.c_str());
 
-  return result;
+  if (stmt.step())
+    return stmt.column(0);
+  else
+    return {};
 }
 
 std::vector<SymbolReference> select_from_symbolreference(Database& db, SymbolId symbol)
@@ -204,7 +264,7 @@ std::vector<SymbolReference> select_from_symbolreference(Database& db, SymbolId
 
   return read_vector<SymbolReference>(stmt, [&symbol](sql::Statement& stmt) {
     SymbolReference symref;
-    symref.file_id = FileId(stmt.columnInt(0));
+    symref.file_id = FileId(stmt.columnInt64(0));
     symref.symbol_id = symbol;
     symref.line = stmt.columnInt(1);
     symref.col = stmt.columnInt(2);
@@ -212,7 +272,7 @@ std::vector<SymbolReference> select_from_symbolreference(Database& db, SymbolId
     if (stmt.nullColumn(3))
       symref.parent_symbol_id = SymbolId();
     else
-      symref.parent_symbol_id = SymbolId(stmt.columnInt(3));
+      symref.parent_symbol_id = SymbolId(stmt.columnInt64(3));
 
     symref.flags = stmt.columnInt(4);
 
@@ -236,14 +296,14 @@ std::vector<SymbolReference> select_symbolreference(Database& db, FileId file)
 
   while (stmt.step())
   {
-    symref.symbol_id = SymbolId(stmt.columnInt(0));
+    symref.symbol_id = SymbolId(stmt.columnInt64(0));
     symref.line = stmt.columnInt(1);
     symref.col = stmt.columnInt(2);
 
     if (stmt.nullColumn(3))
       symref.parent_symbol_id = SymbolId();
     else
-      symref.parent_symbol_id = SymbolId(stmt.columnInt(3));
+      symref.parent_symbol_id = SymbolId(stmt.columnInt64(3));
 
     symref.flags = stmt.columnInt(4);
 
@@ -265,8 +325,8 @@ std::vector<SymbolReference> select_symboldefinition(Database& db)
 
   return read_vector<SymbolReference>(stmt, [](sql::Statement& q) {
     SymbolReference symref;
-    symref.symbol_id = SymbolId(q.columnInt(0));
-    symref.file_id = FileId(q.columnInt(1));
+    symref.symbol_id = SymbolId(q.columnInt64(0));
+    symref.file_id = FileId(q.columnInt64(1));
     symref.line = q.columnInt(2);
     symref.col = q.columnInt(3);
     symref.flags = q.columnInt(4);
@@ -275,7 +335,7 @@ std::vector<SymbolReference> select_symboldefinition(Database& db)
     if (stmt.nullColumn(4))
       symref.parent_symbol_id = SymbolId();
     else
-      symref.parent_symbol_id = SymbolId(stmt.columnInt(3));
+      symref.parent_symbol_id = SymbolId(stmt.columnInt64(3));
 */
     return symref;
     });
@@ -293,7 +353,7 @@ std::vector<BaseClass> select_from_base(Database& db, SymbolId symbol_id)
 
   return read_vector<BaseClass>(stmt, [](sql::Statement& q) {
     BaseClass base;
-    base.base_id = SymbolId(q.columnInt(0));
+    base.base_id = SymbolId(q.columnInt64(0));
     base.access_specifier = static_cast<AccessSpecifier>(q.columnInt(1));
     return base;
     });
@@ -310,7 +370,7 @@ std::vector<SymbolId> select_symbold_id_from_base(Database& db, SymbolId base_id
   stmt.bind(1, base_id.value());
 
   return read_vector<SymbolId>(stmt, [](sql::Statement& q) {
-    return SymbolId(q.columnInt(0));
+    return SymbolId(q.columnInt64(0));
     });
 }
 
@@ -326,9 +386,17 @@ void insert_file(Database& db, const File& file)
   stmt.finalize();
 }
 
+/**
+ * \brief saves the content of files in the database
+ * \param db     the database
+ * \param files  the files
+ * 
+ * The content hash of each file is also updated.
+ * Files that do not exist on disk are skipped.
+ */
 void insert_file_content(Database& db, const std::vector<File*>& files)
 {
-  sql::Statement stmt{ db, "UPDATE file SET content = ? WHERE id = ?" };
+  sql::Statement stmt{ db, "UPDATE file SET content = ?, hash = ? WHERE id = ?" };
 
   for (File* f : files)
   {
@@ -342,8 +410,9 @@ void insert_file_content(Database& db, const std::vector<File*>& files)
 
     std::string bytes = Snapshot::readFile(filepath);
 
-    stmt.bind(2, f->id.value());
+    stmt.bind(3, f->id.value());
     stmt.bind(1, bytes.c_str());
+    stmt.bind(2, content_hash(bytes));
 
     stmt.step();
     stmt.reset();
@@ -352,6 +421,29 @@ void insert_file_content(Database& db, const std::vector<File*>& files)
   stmt.finalize();
 }
 
+/**
+ * \brief saves a given content as the content of a file
+ * \param db       the database
+ * \param file     the id of the file
+ * \param content  the content of the file
+ * \param hash     the content hash, as computed by content_hash()
+ * 
+ * Contrary to the other overload, the file is not read from the disk; 
+ * this is used to copy the content of a file from another snapshot.
+ */
+void insert_file_content(Database& db, FileId file, const std::string& content, const std::string& hash)
+{
+  sql::Statement stmt{ db, "UPDATE file SET content = ?, hash = ? WHERE id = ?" };
+
+  stmt.bind(1, content.c_str());
+  stmt.bind(2, hash.c_str());
+  stmt.bind(3, file.value());
+
+  stmt.step();
+
+  stmt.finalize();
+}
+
 static std::string join(const std::vector<std::string>& list, char sep = ';')
 {
   if (list.empty())
@@ -441,6 +533,35 @@ void insert_translationunit(Database& db, const std::vector<TranslationUnit*>& u
   stmt.finalize();
 }
 
+/**
+ * \brief saves the parsing and indexing times of translation units
+ * 
+ * Negative times are saved as NULL.
+ */
+void insert_translationunit_timings(Database& db, const std::vector<TranslationUnit*>& units)
+{
+  sql::Statement stmt{ db, "UPDATE translationunit SET parsing_time = ?, indexing_time = ? WHERE id = ?" };
+
+  auto bind_time = [&stmt](int n, std::chrono::milliseconds t) {
+    if (t.count() < 0)
+      stmt.bind(n, nullptr);
+    else
+      stmt.bind(n, static_cast<int64_t>(t.count()));
+  };
+
+  for (TranslationUnit* tu : units)
+  {
+    bind_time(1, tu->parsing_time);
+    bind_time(2, tu->indexing_time);
+    stmt.bind(3, tu->id.value());
+
+    stmt.step();
+    stmt.reset();
+  }
+
+  stmt.finalize();
+}
+
 void insert_translationunit_ast(Database& db, TranslationUnit* tu, const std::string& bytes)
 {
   sql::Statement stmt{ db, "UPDATE translationunit SET ast = ? WHERE id = ?" };
@@ -602,7 +723,7 @@ void insert_base(Database& db, const std::map<SymbolId, std::vector<BaseClass>>&
 File read_file(sql::Statement& stmt, int id_col = 0, int path_col = 1)
 {
   File f;
-  f.id = FileId(stmt.columnInt(id_col));
+  f.id = FileId(stmt.columnInt64(id_col));
   f.path = stmt.column(path_col);
   return f;
 }
@@ -615,6 +736,39 @@ std::vector<File> select_file(Database& db)
     });
 }
 
+/**
+ * \brief select the content hash of all files
+ * 
+ * Files that have no hash (e.g., because their content was never saved) 
+ * are not part of the result.
+ */
+std::map<FileId, std::string> select_hash_from_file(Database& db)
+{
+  std::map<FileId, std::string> r;
+
+  if (!has_column(db, "file", "hash"))
+  {
+    // the database was created by an older version of csnap
+    sql::Statement stmt{ db, "SELECT id, content FROM file WHERE content IS NOT NULL" };
+
+    while (stmt.step())
+    {
+      r[FileId(stmt.columnInt64(0))] = content_hash(stmt.column(1));
+    }
+
+    return r;
+  }
+
+  sql::Statement stmt{ db, "SELECT id, hash FROM file WHERE hash IS NOT NULL" };
+
+  while (stmt.step())
+  {
+    r[FileId(stmt.columnInt64(0))] = stmt.column(1);
+  }
+
+  return r;
+}
+
 std::string select_content_from_file(Database& db, FileId file)
 {
   sql::Statement stmt{ db, "SELECT content FROM file WHERE id = ?" };
@@ -707,13 +861,22 @@ std::vector<TranslationUnit> select_translationunit(Database& db)
 {
   std::map<int, std::shared_ptr<program::CompileOptions>> copts = select_compileoptions(db);
 
-  sql::Statement stmt{ db, "SELECT id, file_id, compileoptions_id FROM translationunit" };
+  // the timings are NULL if the database was created by an older version of csnap
+  sql::Statement stmt{ db, has_column(db, "translationunit", "parsing_time") ?
+    "SELECT id, file_id, compileoptions_id, parsing_time, indexing_time FROM translationunit" :
+    "SELECT id, file_id, compileoptions_id, NULL, NULL FROM translationunit" };
+
+  auto read_time = [](sql::Statement& stmt, int n) {
+    return std::chrono::milliseconds(stmt.nullColumn(n) ? -1 : stmt.columnInt64(n));
+  };
 
-  return read_vector<TranslationUnit>(stmt, [&copts](sql::Statement& stmt) {
+  return read_vector<TranslationUnit>(stmt, [&copts, &read_time](sql::Statement& stmt) {
     TranslationUnit tu;
-    tu.id = TranslationUnitId(stmt.columnInt(0));
-    tu.sourcefile_id = FileId(stmt.columnInt(1));
+    tu.id = TranslationUnitId(stmt.columnInt64(0));
+    tu.sourcefile_id = FileId(stmt.columnInt64(1));
     tu.compile_options = copts[stmt.columnInt(2)];
+    tu.parsing_time = read_time(stmt, 3);
+    tu.indexing_time = read_time(stmt, 4);
     return tu;
     });
 }
@@ -736,22 +899,152 @@ std::vector<TranslationUnit> select_translationunit(Database& db)
  */
 std::vector<Include> select_from_include(Database& db, FileId file_id, FileId included_file_id)
 {
-  std::map<int, std::shared_ptr<program::CompileOptions>> copts = select_compileoptions(db);
+  // We use a different query depending on the filters so that sqlite 
+  // can use the indexes on the table.
 
-  sql::Statement stmt{ db, 
-    "SELECT file_id, line, included_file_id FROM include "
-    "WHERE (file_id = ?1 OR ?1 = -1) AND (included_file_id = ?2 OR ?2 = -1)"};
+  sql::Statement stmt{ db };
 
-  stmt.bind(1, file_id.value());
-  stmt.bind(2, included_file_id.value());
+  if (file_id.valid() && included_file_id.valid())
+  {
+    stmt.prepare("SELECT file_id, line, included_file_id FROM include WHERE file_id = ?1 AND included_file_id = ?2");
+    stmt.bind(1, file_id.value());
+    stmt.bind(2, included_file_id.value());
+  }
+  else if (file_id.valid())
+  {
+    stmt.prepare("SELECT file_id, line, included_file_id FROM include WHERE file_id = ?1");
+    stmt.bind(1, file_id.value());
+  }
+  else if (included_file_id.valid())
+  {
+    stmt.prepare("SELECT file_id, line, included_file_id FROM include WHERE included_file_id = ?1");
+    stmt.bind(1, included_file_id.value());
+  }
+  else
+  {
+    stmt.prepare("SELECT file_id, line, included_file_id FROM include");
+  }
 
   return read_vector<Include>(stmt, [](sql::Statement& stmt) {
     Include r;
-    r.file_id = FileId(stmt.columnInt(0));
+    r.file_id = FileId(stmt.columnInt64(0));
     r.line = stmt.columnInt(1);
-    r.included_file_id = FileId(stmt.columnInt(2));
+    r.included_file_id = FileId(stmt.columnInt64(2));
     return r;
     });
 }
 
+/**
+ * \brief select the files included by each translation unit
+ * 
+ * The result is built from the ppinclude table, which contains all the 
+ * #include directives (including nested ones) of each translation unit.
+ */
+std::map<TranslationUnitId, std::set<FileId>> select_included_file_id_from_ppinclude(Database& db)
+{
+  std::map<TranslationUnitId, std::set<FileId>> r;
+
+  sql::Statement stmt{ db, "SELECT DISTINCT translationunit_id, included_file_id FROM ppinclude" };
+
+  while (stmt.step())
+  {
+    r[TranslationUnitId(stmt.columnInt64(0))].insert(FileId(stmt.columnInt64(1)));
+  }
+
+  return r;
+}
+
+/**
+ * \brief select the #include directives processed by each translation unit
+ */
+std::map<TranslationUnitId, std::vector<Include>> select_from_ppinclude(Database& db)
+{
+  std::map<TranslationUnitId, std::vector<Include>> r;
+
+  sql::Statement stmt{ db, "SELECT translationunit_id, file_id, line, included_file_id FROM ppinclude" };
+
+  while (stmt.step())
+  {
+    Include inc;
+    inc.file_id = FileId(stmt.columnInt64(1));
+    inc.line = stmt.columnInt(2);
+    inc.included_file_id = FileId(stmt.columnInt64(3));
+    r[TranslationUnitId(stmt.columnInt64(0))].push_back(inc);
+  }
+
+  return r;
+}
+
+/**
+ * \brief select the number of symbol references in each file
+ */
+std::map<FileId, size_t> select_count_from_symbolreference(Database& db)
+{
+  std::map<FileId, size_t> r;
+
+  sql::Statement stmt{ db, "SELECT file_id, COUNT(*) FROM symbolreference GROUP BY file_id" };
+
+  while (stmt.step())
+  {
+    r[FileId(stmt.columnInt64(0))] = (size_t)stmt.columnInt(1);
+  }
+
+  return r;
+}
+
+/**
+ * \brief select the id and usr of all symbols
+ */
+std::vector<std::pair<SymbolId, std::string>> select_usr_from_symbol(Database& db)
+{
+  sql::Statement stmt{ db, "SELECT id, usr FROM symbol" };
+
+  return read_vector<std::pair<SymbolId, std::string>>(stmt, [](sql::Statement& q) {
+    return std::make_pair(SymbolId(q.columnInt64(0)), q.column(1));
+    });
+}
+
+/**
+ * \brief select the ids of all the symbols that have base classes
+ */
+std::vector<SymbolId> select_distinct_symbol_id_from_base(Database& db)
+{
+  sql::Statement stmt{ db, "SELECT DISTINCT symbol_id FROM base" };
+
+  return read_vector<SymbolId>(stmt, [](sql::Statement& q) {
+    return SymbolId(q.columnInt64(0));
+    });
+}
+
+void delete_from_ppinclude(Database& db, TranslationUnitId tu)
+{
+  sql::Statement stmt{ db, "DELETE FROM ppinclude WHERE translationunit_id = ?" };
+  stmt.bind(1, tu.value());
+  stmt.step();
+}
+
+void delete_from_include(Database& db, FileId file)
+{
+  sql::Statement stmt{ db, "DELETE FROM include WHERE file_id = ?" };
+  stmt.bind(1, file.value());
+  stmt.step();
+}
+
+/**
+ * \brief deletes the base classes of the classes defined in a file
+ */
+void delete_from_base_defined_in(Database& db, FileId file)
+{
+  sql::Statement stmt{ db, "DELETE FROM base WHERE symbol_id IN (SELECT symbol_id FROM symboldefinition WHERE file_id = ?)" };
+  stmt.bind(1, file.value());
+  stmt.step();
+}
+
+void delete_from_symbolreference(Database& db, FileId file)
+{
+  sql::Statement stmt{ db, "DELETE FROM symbolreference WHERE file_id = ?" };
+  stmt.bind(1, file.value());
+  stmt.step();
+}
+
 } // namespace csnap
@@ -6,9 +6,24 @@
 
 #include "snapshot.h"
 
+#include <algorithm>
+#include <string>
+
 namespace csnap
 {
 
+static void read_symbol(const sql::Statement& query, Symbol& symbol)
+{
+  symbol.id = SymbolId(query.columnInt64(0));
+  symbol.kind = static_cast<Whatsit>(query.columnInt(1));
+
+  symbol.parent_id = query.nullColumn(2) ? SymbolId() : SymbolId(query.columnInt64(2));
+  symbol.name = query.column(3);
+  symbol.usr = query.column(4);
+  symbol.display_name = query.nullColumn(5) ? std::string() : query.column(5);
+  symbol.flags = query.columnInt(6);
+}
+
 SymbolLoader::SymbolLoader(Database& db) :
   database(db),
   m_query(db, "SELECT id, what, parent, name, usr, displayname, flags FROM symbol WHERE id = ?")
@@ -42,14 +57,7 @@ bool SymbolLoader::read(SymbolId id)
   if (!m_query.step())
     return false;
 
-  symbol.id = id;
-  symbol.kind = static_cast<Whatsit>(m_query.columnInt(1));
-
-  symbol.parent_id = m_query.nullColumn(2) ? SymbolId() : SymbolId(m_query.columnInt(2));
-  symbol.name = m_query.column(3);
-  symbol.usr = m_query.column(4);
-  symbol.display_name = m_query.nullColumn(5) ? std::string() : m_query.column(5);
-  symbol.flags = m_query.columnInt(6);
+  read_symbol(m_query, symbol);
 
   return true;
 }
@@ -57,7 +65,7 @@ bool SymbolLoader::read(SymbolId id)
 
 SymbolEnumerator::SymbolEnumerator(Database& db) :
   database(db),
-  m_query(db, "SELECT id, what, parent, name, usr, displayname, flags FROM symbol")
+  m_query(db, "SELECT id, what, parent, name, usr, displayname, flags FROM symbol ORDER BY id")
 {
 
 }
@@ -80,16 +88,71 @@ bool SymbolEnumerator::next()
   if (!m_query.step())
     return false;
 
-  symbol.id = SymbolId(m_query.columnInt(0));
-  symbol.kind = static_cast<Whatsit>(m_query.columnInt(1));
-
-  symbol.parent_id = m_query.nullColumn(2) ? SymbolId() : SymbolId(m_query.columnInt(2));
-  symbol.name = m_query.column(3);
-  symbol.usr = m_query.column(4);
-  symbol.display_name = m_query.nullColumn(5) ? std::string() : m_query.column(5);
-  symbol.flags = m_query.columnInt(6);
+  read_symbol(m_query, symbol);
 
   return true;
 }
 
+static std::string batch_query()
+{
+  std::string query = "SELECT id, what, parent, name, usr, displayname, flags FROM symbol WHERE id IN (?";
+
+  for (size_t i(1); i < SymbolBatchLoader::BatchSize; ++i)
+    query += ",?";
+
+  query += ")";
+
+  return query;
+}
+
+SymbolBatchLoader::SymbolBatchLoader(Database& db) :
+  database(db),
+  m_query(db, batch_query().c_str())
+{
+
+}
+
+/**
+ * \brief constructs a batch loader on a snapshot
+ * \param s  the snapshot
+ */
+SymbolBatchLoader::SymbolBatchLoader(const Snapshot& s) : SymbolBatchLoader(s.database())
+{
+
+}
+
+/**
+ * \brief loads symbols from the database
+ * \param ids  the ids of the symbols
+ * \return the symbols that were found, in no particular order
+ * 
+ * Ids that do not correspond to a symbol are ignored.
+ */
+std::vector<Symbol> SymbolBatchLoader::read(const std::vector<SymbolId>& ids)
+{
+  std::vector<Symbol> result;
+  result.reserve(ids.size());
+
+  for (size_t offset(0); offset < ids.size(); offset += BatchSize)
+  {
+    m_query.reset();
+
+    size_t n = std::min(BatchSize, ids.size() - offset);
+
+    for (size_t i(0); i < BatchSize; ++i)
+    {
+      // the last batch is padded with an id that does not exist
+      m_query.bind((int)i + 1, i < n ? ids[offset + i].value() : -1);
+    }
+
+    while (m_query.step())
+    {
+      result.emplace_back();
+      read_symbol(m_query, result.back());
+    }
+  }
+
+  return result;
+}
+
 } // namespace csnap
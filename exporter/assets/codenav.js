@@ -127,6 +127,18 @@ var csnapCodeNav = {
     return this.implGetParentTD(elem).previousSibling.id.slice(1);
   },
 
+  // must be kept in sync with SourceHighlighter::symbol_page()
+  implSymbolPage: function(symref) {
+    var id = symref.slice(0, symref.indexOf('.'));
+    var depth = (typeof csnapSymbolShardDepth !== 'undefined') ? csnapSymbolShardDepth : 0;
+    var value = BigInt(id);
+    var path = 'symbols/';
+    for(var i = 0; i < depth; ++i) {
+      path += ((value >> BigInt(8 * i)) & 0xFFn).toString(16).padStart(2, '0') + '/';
+    }
+    return path + id + '.html';
+  },
+
   implShowTooltip: function(elem, symref) {
     var references = document.querySelectorAll('[sym-ref="' + symref + '"]');
     var content = "<b>" + references.length + " reference(s) in this document</b><br/>";
@@ -134,7 +146,7 @@ var csnapCodeNav = {
       content += "Line " + csnapCodeNav.implGetLine(ref) + "<br/>";
     });
     
-    content += `<div style='text-align: right;'><a href='${csnapRootPath}symbols/${symref}.html'>More...</a></div>`;
+    content += `<div style='text-align: right;'><a href='${csnapRootPath}${this.implSymbolPage(symref)}'>More...</a></div>`;
     
     // $TODO: see what we can do to collect references in other documents 
     // asynchronously (e.g., with XMLHttpRequest).
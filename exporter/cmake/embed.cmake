@@ -9,7 +9,7 @@ function(create_resources dir name)
     # Start writing content
     file(APPEND ${output} "#include <filesystem>\n")
     file(APPEND ${output} "#include <string>\n")
-    file(APPEND ${output} "namespace csnap { extern void copy_resource(const std::string& name, const void* data, size_t nbbytes, const std::filesystem::path& outdir); }\n")
+    file(APPEND ${output} "namespace csnap { class OutputSink; extern void copy_resource(const std::string& name, const void* data, size_t nbbytes, OutputSink& output); }\n")
     file(APPEND ${output} "extern \"C\"{\n")
     # Collect input files
     file(GLOB bins ${dir}/*)
@@ -29,11 +29,11 @@ function(create_resources dir name)
         file(APPEND ${output} "const unsigned char ${fileidentifier}[] = {\n${filedata}};\nconst size_t ${fileidentifier}_size = sizeof(${fileidentifier});\n")
     endforeach()
     file(APPEND ${output} "} // extern \"C\"\n")
-    file(APPEND ${output} "void export_resources_${name}(const std::filesystem::path& outdir){\n")
+    file(APPEND ${output} "void export_resources_${name}(csnap::OutputSink& output){\n")
     foreach(bin ${bins})
       string(REGEX MATCH "([^/]+)$" filename ${bin})
       string(REGEX REPLACE "\\.| |-" "_" fileidentifier ${filename})
-      file(APPEND ${output} "csnap::copy_resource(\"${filename}\", ${fileidentifier}, ${fileidentifier}_size, outdir);\n")
+      file(APPEND ${output} "csnap::copy_resource(\"${filename}\", ${fileidentifier}, ${fileidentifier}_size, output);\n")
     endforeach()
     file(APPEND ${output} "}\n")
     set(EMBED_RESOURCE_${name} "${CMAKE_BINARY_DIR}/${name}.cpp" PARENT_SCOPE)
@@ -9,6 +9,8 @@
 #include "csnap/model/reference.h"
 
 #include <cstddef>
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 namespace csnap
@@ -29,7 +31,7 @@ public:
 
 private:
   std::vector<SymbolReference> m_definitions;
-  std::vector<size_t> m_table;
+  std::unordered_map<int64_t, size_t> m_table;
 };
 
 } // namespace cxx
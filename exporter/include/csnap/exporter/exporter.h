@@ -5,10 +5,17 @@
 #ifndef CSNAP_EXPORTER_H
 #define CSNAP_EXPORTER_H
 
+#include "csnap/exporter/outputsink.h"
+#include "csnap/exporter/pagemanifest.h"
+
 #include "csnap/database/snapshot.h"
 
+#include "csnap/model/symboltable.h"
+
 #include <filesystem>
 #include <map>
+#include <memory>
+#include <thread>
 
 namespace csnap
 {
@@ -31,6 +38,14 @@ public:
    */
   std::filesystem::path outputdir;
 
+  /**
+   * \brief path of an archive in which the html files are going to be written
+   * 
+   * If this path is not empty, all the files are streamed into a single 
+   * tar archive instead of being written in \a outputdir.
+   */
+  std::filesystem::path archive;
+
   /**
    * \brief root path for the input files
    * 
@@ -45,6 +60,47 @@ public:
    */
   std::string rootpath;
 
+  /**
+   * \brief number of threads used to generate the file pages
+   * 
+   * Each thread opens its own connection to the snapshot database.
+   * A value of 1 (or less) generates the pages on the calling thread.
+   */
+  size_t nb_threads = std::thread::hardware_concurrency();
+
+  /**
+   * \brief memory budget for the symbol and file content caches, in bytes
+   * 
+   * When generating the file pages in parallel, the budget is shared 
+   * between the threads.
+   * The cache of tokenized files used by the symbol pages gets half 
+   * of this budget.
+   * A value of 0 keeps the default budgets of the caches.
+   */
+  size_t cache_size = 0;
+
+  /**
+   * \brief number of levels of sub-directories used for the symbol pages
+   * 
+   * Symbol pages are saved in "symbols/" under this many levels of 
+   * sub-directories derived from the symbol id 
+   * (see SourceHighlighter::symbol_page()).
+   * A value of 0 puts all the pages in the same directory.
+   */
+  int symbol_shard_depth = 2;
+
+  /**
+   * \brief whether only the pages whose inputs changed are regenerated
+   * 
+   * When exporting in \a outputdir, the exporter saves a manifest 
+   * mapping each page to a hash of its inputs.
+   * If this member is true, pages whose inputs have the same hash as in the 
+   * manifest of the previous export are not rewritten; pages that are no 
+   * longer part of the export are deleted.
+   * This has no effect when exporting to an \a archive.
+   */
+  bool incremental = true;
+
 public:
   explicit SnapshotExporter(Snapshot& s);
 
@@ -52,9 +108,14 @@ public:
 
 protected:
   void detectRootPath();
-  std::map<File*, std::filesystem::path> writeFilePages();
+  std::map<File*, std::filesystem::path> writeFilePages(const SymbolTable& symbols);
   void writeDirectoryPages(const std::map<File*, std::filesystem::path>& paths);
-  void writeSymbolPages();
+  void writeSymbolPages(const SymbolTable& symbols);
+  void removeStalePages();
+
+private:
+  std::unique_ptr<OutputSink> m_output;
+  PageManifest m_manifest;
 };
 
 } // namespace csnap
@@ -16,17 +16,23 @@ class FileBrowserGenerator : public SourceHighlighter
 {
 public:
 
-  FileBrowserGenerator(HtmlPage& p, const FileContent& fc, FileSema fm, const FileList& fs, const SymbolMap& ss, const DefinitionTable& defs);
+  FileBrowserGenerator(HtmlPage& p, std::shared_ptr<const FileTokens> ft, FileSema fm, const FileList& fs, const SymbolTable& ss, const DefinitionTable& defs);
 
   void generatePage();
   void generate();
   void generate(const std::set<int>& lines);
 
+  int symbolShardDepth() const;
+  void setSymbolShardDepth(int depth);
+
 protected:
 
   void writeLine(size_t i);
 
   void writeCode();
+
+private:
+  int m_shard_depth = 2;
 };
 
 } // namespace csnap
@@ -9,6 +9,8 @@
 #include "pathresolver.h"
 
 #include <filesystem>
+#include <string>
+#include <unordered_map>
 
 namespace csnap
 {
@@ -20,7 +22,9 @@ class FilePageLinker
 {
 protected:
   PageURL m_url;
+  std::string m_url_path;
   PathResolver* m_path_resolver = nullptr;
+  mutable std::unordered_map<int64_t, std::string> m_file_links;
 
 public:
   explicit FilePageLinker(PageURL url);
@@ -8,10 +8,12 @@
 #include <csnap/model/file.h>
 #include <csnap/model/include.h>
 #include <csnap/model/reference.h>
+#include <csnap/model/symboltable.h>
 
 #include <algorithm>
 #include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace csnap
@@ -41,8 +43,41 @@ struct FileSema
    * \brief the list of files that are including this file
    */
   std::vector<Include> reverse_includes;
+
+  /**
+   * \brief for each line, offset of the first reference on or after that line
+   * 
+   * This table is filled by index_lines().
+   * The references of line \c l are in the range [references_by_line[l], references_by_line[l+1]).
+   */
+  std::vector<size_t> references_by_line;
+
+  /**
+   * \brief for each line, offset of the first include on or after that line
+   * 
+   * \sa references_by_line.
+   */
+  std::vector<size_t> includes_by_line;
 };
 
+void index_lines(FileSema& sema);
+
+/**
+ * \brief returns the range of the elements of a given line in a table built by index_lines()
+ * \param table  the table, either FileSema::references_by_line or FileSema::includes_by_line
+ * \param line   the line number (starting at 1)
+ * \return a pair of offsets [begin, end)
+ */
+inline std::pair<size_t, size_t> line_range(const std::vector<size_t>& table, int line)
+{
+  auto l = static_cast<size_t>(line);
+
+  if (line <= 0 || l + 1 >= table.size())
+    return std::make_pair(table.empty() ? 0 : table.back(), table.empty() ? 0 : table.back());
+
+  return std::make_pair(table[l], table[l + 1]);
+}
+
 /**
  * \brief remove all references from a list that are implicit
  * \param refs  the list to clean up
@@ -56,7 +91,7 @@ inline void remove_implicit_references(std::vector<SymbolReference>& refs)
   refs.erase(it, refs.end());
 }
 
-void simplify_ctor_and_class_references(std::vector<SymbolReference>& refs, const std::map<SymbolId, std::shared_ptr<Symbol>>& symbols);
+void simplify_ctor_and_class_references(std::vector<SymbolReference>& refs, const SymbolTable& symbols);
 
 } // namespace csnap
 
@@ -0,0 +1,156 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#ifndef CSNAP_FILETOKENS_H
+#define CSNAP_FILETOKENS_H
+
+#include <csnap/model/filecontent.h>
+#include <csnap/model/lrucache.h>
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace csnap
+{
+
+class Snapshot;
+
+/**
+ * \brief the tokens of a whole file
+ * 
+ * The file is tokenized once, line by line, and each token is stored as 
+ * a compact (offset, length, kind) record referring to the FileContent.
+ * Token texts are returned as views into the content of the file.
+ */
+class FileTokens
+{
+public:
+
+  /**
+   * \brief the kind of a token, as needed for syntax highlighting
+   */
+  enum Kind : uint8_t
+  {
+    Other,
+    Keyword,
+    Identifier,
+    Operator,
+    Punctuator,
+    Comment,
+    Preproc,
+    Include,
+    Literal,
+  };
+
+  struct Token
+  {
+    uint32_t offset;
+    uint32_t length;
+    Kind kind;
+  };
+
+  using TokenIterator = std::vector<Token>::const_iterator;
+
+public:
+  explicit FileTokens(std::shared_ptr<FileContent> fc);
+  FileTokens(const FileTokens&) = delete;
+
+  const FileContent& content() const;
+
+  size_t lineCount() const;
+  TokenIterator lineBegin(int l) const;
+  TokenIterator lineEnd(int l) const;
+
+  std::string_view text(const Token& tok) const;
+  int column(const Token& tok, int l) const;
+
+  size_t memoryUsage() const;
+
+  FileTokens& operator=(const FileTokens&) = delete;
+
+private:
+  std::shared_ptr<FileContent> m_content;
+  std::vector<Token> m_tokens;
+  std::vector<uint32_t> m_lines; // index of the first token of each line, plus one past the end
+};
+
+/**
+ * \brief returns the content of the file
+ */
+inline const FileContent& FileTokens::content() const
+{
+  return *m_content;
+}
+
+/**
+ * \brief returns the number of lines in the file
+ */
+inline size_t FileTokens::lineCount() const
+{
+  return m_lines.size() - 1;
+}
+
+/**
+ * \brief returns an iterator to the first token of a line
+ * \param l  the line number, starting at 1
+ */
+inline FileTokens::TokenIterator FileTokens::lineBegin(int l) const
+{
+  return m_tokens.begin() + m_lines[size_t(l) - 1];
+}
+
+/**
+ * \brief returns an iterator past the last token of a line
+ * \param l  the line number, starting at 1
+ */
+inline FileTokens::TokenIterator FileTokens::lineEnd(int l) const
+{
+  return m_tokens.begin() + m_lines[size_t(l)];
+}
+
+/**
+ * \brief returns the text of a token
+ */
+inline std::string_view FileTokens::text(const Token& tok) const
+{
+  return std::string_view(m_content->content.data() + tok.offset, tok.length);
+}
+
+/**
+ * \brief returns the column of a token, starting at 0
+ * \param tok  the token
+ * \param l    the line of the token, starting at 1
+ */
+inline int FileTokens::column(const Token& tok, int l) const
+{
+  const char* linestart = m_content->lines[size_t(l) - 1].data();
+  return static_cast<int>(m_content->content.data() + tok.offset - linestart);
+}
+
+/**
+ * \brief a cache of tokenized files with a memory budget
+ * 
+ * Files are loaded from a snapshot and tokenized on demand.
+ */
+class FileTokensCache
+{
+public:
+  static constexpr size_t DefaultBudget = 32 * 1024 * 1024;
+
+  explicit FileTokensCache(Snapshot& s, size_t budget = DefaultBudget);
+
+  std::shared_ptr<const FileTokens> get(FileId id);
+
+  const CacheStats& stats() const;
+
+private:
+  Snapshot& m_snapshot;
+  LruCache<FileTokens> m_data;
+};
+
+} // namespace csnap
+
+#endif // CSNAP_FILETOKENS_H
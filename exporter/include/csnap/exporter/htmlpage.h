@@ -68,12 +68,12 @@ inline std::string HtmlPage::linkTo(const std::filesystem::path& otherPage) cons
 
 inline void HtmlPage::write(const std::string& txt)
 {
-  xml.stream() << txt;
+  xml.write(txt);
 }
 
 inline HtmlPage& operator<<(HtmlPage& page, int val)
 {
-  page.xml.stream() << val;
+  page.xml.write(std::to_string(val));
   return page;
 }
 
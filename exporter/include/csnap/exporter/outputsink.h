@@ -0,0 +1,58 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#ifndef CSNAP_OUTPUTSINK_H
+#define CSNAP_OUTPUTSINK_H
+
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace csnap
+{
+
+/**
+ * \brief destination of the files produced by the exporter
+ * 
+ * Files are identified by a path relative to the root of the export, 
+ * using '/' as separator.
+ * 
+ * Implementations must allow write() to be called concurrently from 
+ * several threads.
+ */
+class OutputSink
+{
+public:
+  virtual ~OutputSink();
+
+  virtual void write(const std::string& path, const std::string& content) = 0;
+
+  virtual void close();
+};
+
+/**
+ * \brief output sink that writes each file on disk, under a directory
+ */
+class DirectorySink : public OutputSink
+{
+public:
+  explicit DirectorySink(std::filesystem::path dir);
+
+  const std::filesystem::path& directory() const;
+
+  void write(const std::string& path, const std::string& content) override;
+
+protected:
+  void createParentDirectory(const std::filesystem::path& p);
+
+private:
+  std::filesystem::path m_directory;
+  std::mutex m_mutex;
+  std::set<std::filesystem::path> m_created_directories;
+};
+
+} // namespace csnap
+
+#endif // CSNAP_OUTPUTSINK_H
@@ -0,0 +1,74 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#ifndef CSNAP_PAGEMANIFEST_H
+#define CSNAP_PAGEMANIFEST_H
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace csnap
+{
+
+/**
+ * \brief computes a 64-bit hash of the inputs of a page
+ * 
+ * This uses the FNV-1a hash function; strings are prefixed by their 
+ * length so that consecutive values cannot be confused.
+ */
+class InputHasher
+{
+public:
+  InputHasher& add(std::string_view str);
+  InputHasher& add(int64_t n);
+
+  uint64_t value() const;
+
+private:
+  void addBytes(const void* data, size_t n);
+
+private:
+  uint64_t m_value = 14695981039346656037ull;
+};
+
+/**
+ * \brief records, for each page of an export, a hash of the inputs of the page
+ * 
+ * The manifest of the previous export is loaded with load().
+ * During the export, pages whose inputs have the same hash as in the 
+ * previous export can be skipped (see isUpToDate()); every page of the 
+ * export is recorded with update().
+ * Pages that were in the previous manifest but were not recorded are 
+ * stale and can be deleted.
+ */
+class PageManifest
+{
+public:
+  static const char* FileName;
+
+  void load(const std::filesystem::path& file);
+  void save(const std::filesystem::path& file) const;
+  void clear();
+
+  bool isUpToDate(const std::string& page, uint64_t hash) const;
+  void update(const std::string& page, uint64_t hash);
+
+  size_t size() const;
+  std::vector<std::string> stalePages() const;
+
+private:
+  std::unordered_map<std::string, uint64_t> m_previous;
+  std::map<std::string, uint64_t> m_current;
+  mutable std::mutex m_mutex;
+};
+
+} // namespace csnap
+
+#endif // CSNAP_PAGEMANIFEST_H
@@ -5,6 +5,7 @@
 #ifndef CSNAP_PAGEURL_H
 #define CSNAP_PAGEURL_H
 
+#include "pathresolver.h"
 #include "xmlwriter.h"
 
 #include <algorithm>
@@ -85,12 +86,12 @@ inline void PageURL::setPath(const std::filesystem::path& fp)
 /**
  * \brief computes a relative link to another page
  * \param other  the path to the other page
+ * 
+ * \sa csnap::PathResolver::relpath().
  */
 inline std::string PageURL::linkTo(const std::filesystem::path& other) const
 {
-  std::filesystem::path current_dir = path().parent_path();
-  std::filesystem::path relpath = std::filesystem::relative(other, current_dir);
-  return relpath.generic_u8string();
+  return csnap::PathResolver::relpath(path().generic_u8string(), other.generic_u8string());
 }
 
 #endif // CSNAP_PAGEURL_H
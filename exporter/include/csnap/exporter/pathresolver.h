@@ -8,6 +8,8 @@
 #include <csnap/model/file.h>
 
 #include <filesystem>
+#include <string>
+#include <string_view>
 
 namespace csnap
 {
@@ -20,7 +22,7 @@ class PathResolver
 public:
   virtual ~PathResolver();
 
-  static std::string relpath(const std::string& source, const std::string& target);
+  static std::string relpath(std::string_view source, std::string_view target);
 
   virtual std::filesystem::path filePath(const File& f) const;
 };
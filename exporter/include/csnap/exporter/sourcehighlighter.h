@@ -7,13 +7,13 @@
 
 #include "definitiontable.h"
 #include "filesema.h"
+#include "filetokens.h"
 #include "iterator.h"
 
 #include <csnap/model/filecontent.h>
 #include <csnap/model/filelist.h>
 #include <csnap/model/symbol.h>
-
-#include <cpptok/tokenizer.h>
+#include <csnap/model/symboltable.h>
 
 #include <filesystem>
 #include <map>
@@ -32,10 +32,7 @@ class PathResolver;
 class SourceHighlighter
 {
 public:
-  using SymbolPtr = std::shared_ptr<Symbol>;
-  using SymbolMap = std::map<SymbolId, std::shared_ptr<Symbol>>;
-
-  using TokenIterator = Iterator<std::vector<cpptok::Token>::const_iterator>;
+  using TokenIterator = Iterator<FileTokens::TokenIterator>;
   using IncludeIterator = Iterator<std::vector<Include>::const_iterator>;
   using ReferenceIterator = Iterator<std::vector<SymbolReference>::const_iterator>;
 
@@ -47,20 +44,21 @@ public:
 
 protected:
   HtmlPage& page;
+  std::shared_ptr<const FileTokens> tokens;
   const FileContent& content;
   FileSema sema;
   const FileList& files;
-  const SymbolMap& symbols;
+  const SymbolTable& symbols;
   const DefinitionTable& definitions; // $TODO: make optional, only makes sense if we may to link to other pages
-  cpptok::Tokenizer lexer;
   int m_current_line = -1;
-  std::unique_ptr<SemaIterators> current_line_sema;
 
 public:
 
-  SourceHighlighter(HtmlPage& p, const FileContent& fc, FileSema fm, const FileList& fs, const SymbolMap& ss, const DefinitionTable& defs);
+  SourceHighlighter(HtmlPage& p, std::shared_ptr<const FileTokens> ft, FileSema fm, const FileList& fs, const SymbolTable& ss, const DefinitionTable& defs);
   
   static std::string symbol_symref(const Symbol& sym);
+  static std::string symbol_symref(SymbolId id, std::string_view name);
+  static std::string symbol_page(SymbolId id, int shard_depth);
 
   void writeLineSource(int l);
 
@@ -68,18 +66,18 @@ protected:
 
   int currentLine() const;
   const std::string_view& currentText() const;
+  SemaIterators lineSema(int l) const;
 
   std::string pathHref(const std::filesystem::path& p) const;
 
-  static std::string tagFromKeyword(const std::string& kw);
+  static const char* tagFromKeyword(std::string_view kw);
 
   static const std::string& cssClass(const Symbol& sym);
+  static const std::string& cssClass(Whatsit kind);
 
-  static int getTokCol(std::string_view text, const cpptok::Token& tok);
-
-  void insertPrecedingSpaces(std::string_view text, size_t& col, const cpptok::Token& tok);
+  void insertPrecedingSpaces(size_t& col, const FileTokens::Token& tok);
 
-  void writeToken(size_t& col, const cpptok::Token& tok);
+  void writeToken(size_t& col, const FileTokens::Token& tok);
 
   void writeToken(size_t& col, TokenIterator& tokit);
 
@@ -91,7 +89,7 @@ protected:
 
   void writeTokens(size_t& col, TokenIterator& tokit, SemaIterators& sema);
 
-  void writeLineSource(const std::vector<cpptok::Token>& tokens, SemaIterators& sema);
+  void writeLineSource(TokenIterator& tokit, SemaIterators& sema);
 };
 
 } // namespace csnap
@@ -5,11 +5,14 @@
 #ifndef CSNAP_SYMBOLPAGE_H
 #define CSNAP_SYMBOLPAGE_H
 
+#include "filetokens.h"
 #include "htmlpage.h"
 #include "pathresolver.h"
 
 #include "csnap/database/snapshot.h"
 
+#include "csnap/model/symboltable.h"
+
 namespace csnap
 {
 
@@ -23,10 +26,20 @@ public:
 public:
 
   SymbolPageGenerator(HtmlPage& p, Snapshot& snap, const Symbol& sym);
+  SymbolPageGenerator(HtmlPage& p, Snapshot& snap, const Symbol& sym, std::vector<SymbolReference> refs);
 
   PathResolver* pathResolver() const;
   void setPathResolver(PathResolver& resolver);
 
+  const SymbolTable* symbolTable() const;
+  void setSymbolTable(const SymbolTable& table);
+
+  FileTokensCache* tokensCache() const;
+  void setTokensCache(FileTokensCache& cache);
+
+  int symbolShardDepth() const;
+  void setSymbolShardDepth(int depth);
+
   void writePage();
 
 protected:
@@ -38,6 +51,16 @@ protected:
   void writeUses(const std::vector<SymbolReference>& list);
   using RefIterator = std::vector<SymbolReference>::const_iterator;
   void writeUsesInFile(RefIterator begin, RefIterator end);
+  const std::vector<SymbolReference>& references();
+  bool findSymbolName(SymbolId id, std::string& name);
+  std::string symbolHref(SymbolId id) const;
+
+private:
+  const SymbolTable* m_symbols = nullptr;
+  FileTokensCache* m_tokens_cache = nullptr;
+  int m_shard_depth = 2;
+  std::vector<SymbolReference> m_references;
+  bool m_references_loaded = false;
 };
 
 } // namespace csnap
@@ -0,0 +1,51 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#ifndef CSNAP_TARSINK_H
+#define CSNAP_TARSINK_H
+
+#include "outputsink.h"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+
+namespace csnap
+{
+
+/**
+ * \brief output sink that streams all the files into a single tar archive
+ * 
+ * The archive is written sequentially, in the order in which the files 
+ * are received; it uses the ustar format, with GNU long name entries 
+ * for paths that do not fit in the ustar header.
+ * 
+ * All entries have a modification time of zero, so the archive only 
+ * depends on the files and on the order in which they are written.
+ */
+class TarSink : public OutputSink
+{
+public:
+  explicit TarSink(const std::filesystem::path& archive);
+  ~TarSink();
+
+  void write(const std::string& path, const std::string& content) override;
+  void close() override;
+
+  size_t count() const;
+
+protected:
+  void writeHeader(const std::string& name, size_t size, char type);
+  void writeData(const char* data, size_t size);
+
+private:
+  std::ofstream m_file;
+  std::mutex m_mutex;
+  std::atomic<size_t> m_count{ 0 };
+  bool m_closed = false;
+};
+
+} // namespace csnap
+
+#endif // CSNAP_TARSINK_H
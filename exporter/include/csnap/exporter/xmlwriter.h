@@ -15,6 +15,9 @@
  * 
  * This class provides a friendly interface to write XML files.
  * 
+ * Output is accumulated in a contiguous buffer which is written to the 
+ * output stream in large blocks.
+ * 
  * \note This class does not enforce compliance with any XML standard.
  * In particular, this class does not ensure that the resulting XML document 
  * has a single root element.
@@ -26,16 +29,22 @@ public:
 
   explicit XmlWriter(OutputStream& output);
   XmlWriter(const XmlWriter&) = delete;
+  ~XmlWriter();
 
   OutputStream& stream() const;
+  void flush() const;
 
   void write(const std::string& txt);
+  void write(std::string_view txt);
+  void write(const char* str);
 
   void writeStartElement(const std::string& qname);
+  void writeStartElement(std::string_view qname);
+  void writeStartElement(const char* qname);
   void writeEndElement();
 
-  void writeAttribute(const std::string& name, const std::string& value);
-  void writeAttribute(const std::string& name, int value);
+  void writeAttribute(std::string_view name, std::string_view value);
+  void writeAttribute(std::string_view name, int value);
 
   void writeCharacters(const std::string& text);
   void writeCharacters(std::string_view text);
@@ -48,17 +57,43 @@ protected:
 
   struct Element
   {
-    std::string name;
+    size_t name_offset = 0;
+    size_t name_size = 0;
     bool attributes_closed = false;
   };
 
   bool withinElement() const;
   Element& current();
   void sealAttributes();
+  void flushIfFull();
 
 private:
   OutputStream& m_output;
+  mutable std::string m_buffer;
   std::vector<Element> m_elements;
+  std::string m_element_names;
 };
 
+/**
+ * \brief write bytes to the output
+ * 
+ * \warning Unlike writeCharacters(), this function does not escape 
+ * special XML characters like '<'.
+ */
+inline void XmlWriter::write(std::string_view txt)
+{
+  m_buffer.append(txt.data(), txt.size());
+  flushIfFull();
+}
+
+inline void XmlWriter::write(const std::string& txt)
+{
+  write(std::string_view(txt));
+}
+
+inline void XmlWriter::write(const char* str)
+{
+  write(std::string_view(str));
+}
+
 #endif // CSNAP_XMLWRITER_H
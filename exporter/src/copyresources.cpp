@@ -2,15 +2,15 @@
 // This file is part of the 'csnap' project.
 // For conditions of distribution and use, see copyright notice in LICENSE.
 
-#include "writefile.h"
+#include "outputsink.h"
 
 namespace csnap
 {
 
-void copy_resource(const std::string& name, const void* data, size_t nbbytes, const std::filesystem::path& outdir)
+void copy_resource(const std::string& name, const void* data, size_t nbbytes, OutputSink& output)
 {
   auto content = std::string(reinterpret_cast<const char*>(data), nbbytes);
-  write_file(outdir / name, content);
+  output.write(name, content);
 }
 
 } // namespace csnap
@@ -5,7 +5,6 @@
 #include "definitiontable.h"
 
 #include <algorithm>
-#include <limits>
 #include <stdexcept>
 
 namespace csnap
@@ -15,7 +14,8 @@ namespace csnap
  * \brief builds the table
  * \param defs  a list of all symbol definitions
  * 
- * This function will sort @a defs and create a fast (O(1)) lookup table.
+ * This function will sort @a defs and create a fast (O(1)) lookup table 
+ * from symbol id to the offset of the first definition of the symbol.
  */
 void DefinitionTable::build(std::vector<SymbolReference> defs)
 {
@@ -30,24 +30,21 @@ void DefinitionTable::build(std::vector<SymbolReference> defs)
       return a.symbol_id < b.symbol_id;
     });
 
-  int max_symbol_id = m_definitions.back().symbol_id.value();
-
-  m_table.resize(static_cast<size_t>(max_symbol_id) + 1, std::numeric_limits<size_t>::max());
-
-  int current_symbol_id = m_definitions.front().symbol_id.value();
+  SymbolId current_symbol_id = m_definitions.front().symbol_id;
   size_t current_start_offset = 0;
 
   for (size_t i(0); i < m_definitions.size(); ++i)
   {
-    if (m_definitions.at(i).symbol_id.value() != current_symbol_id)
+    if (m_definitions.at(i).symbol_id != current_symbol_id)
     {
-      auto symoffset = static_cast<size_t>(current_symbol_id);
-      m_table[symoffset] = current_start_offset;
+      m_table[current_symbol_id.value()] = current_start_offset;
 
-      current_symbol_id = m_definitions.at(i).symbol_id.value();
+      current_symbol_id = m_definitions.at(i).symbol_id;
       current_start_offset = i;
     }
   }
+
+  m_table[current_symbol_id.value()] = current_start_offset;
 }
 
 /**
@@ -61,12 +58,12 @@ void DefinitionTable::build(std::vector<SymbolReference> defs)
  */
 bool DefinitionTable::hasUniqueDefinition(SymbolId id, SymbolReference* def) const
 {
-  auto symoffset = static_cast<size_t>(id.value());
+  auto it = m_table.find(id.value());
 
-  if (m_table.size() <= symoffset || m_table[symoffset] == std::numeric_limits<size_t>::max())
+  if (it == m_table.end())
     return false;
 
-  size_t firstdef = m_table[symoffset];
+  size_t firstdef = it->second;
 
   if (firstdef + 1 == m_definitions.size() || m_definitions[firstdef + 1].symbol_id != id)
   {
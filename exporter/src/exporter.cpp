@@ -6,25 +6,93 @@
 
 #include "directorypage.h"
 #include "filebrowser.h"
+#include "filetokens.h"
+#include "pagemanifest.h"
 #include "symbolpage.h"
-#include "writefile.h"
+#include "tarsink.h"
 #include "xmlwriter.h"
 
+#include "csnap/database/referenceenumerator.h"
 #include "csnap/database/sqlqueries.h"
 #include "csnap/database/symbolloader.h"
 
+#include "csnap/model/version.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <fstream>
+#include <mutex>
 #include <set>
 #include <sstream>
+#include <unordered_map>
 
 #include <iostream>
 
-extern void export_resources_html_assets(const std::filesystem::path& outdir);
+extern void export_resources_html_assets(csnap::OutputSink& output);
 
 namespace csnap
 {
 
-void export_html(Snapshot& snapshot, File& file, const std::filesystem::path& outputdir, const std::filesystem::path& outputpath, const DefinitionTable& defs, PathResolver& pathresolver)
+/**
+ * \brief returns the version of csnap, which is part of the inputs of every page
+ */
+static const std::string& generator_version()
+{
+  static const std::string version = versionstring();
+  return version;
+}
+
+/**
+ * \brief computes the hash of the inputs of a file page
+ * 
+ * The inputs are the content of the file, its references and includes, 
+ * the name and kind of the referenced symbols and the targets of the 
+ * links (definitions and included files).
+ */
+static uint64_t file_page_hash(const FileContent& content, const FileSema& sema, const std::string& outputpath, const FileList& files, const SymbolTable& symbols, const DefinitionTable& defs, PathResolver& pathresolver, int shard_depth)
+{
+  InputHasher hasher;
+  hasher.add(generator_version()).add(outputpath).add(shard_depth);
+  hasher.add(sema.file->path).add(content.content);
+
+  auto add_file_link = [&](FileId id) {
+    const File* f = files.get(id);
+    hasher.add(f ? pathresolver.filePath(*f).generic_u8string() : std::string());
+  };
+
+  for (const SymbolReference& ref : sema.references)
+  {
+    hasher.add(ref.symbol_id.value()).add(ref.line).add(ref.col).add(ref.flags);
+
+    if (symbols.contains(ref.symbol_id))
+      hasher.add(symbols.name(ref.symbol_id)).add(static_cast<int>(symbols.kind(ref.symbol_id)));
+
+    SymbolReference def;
+
+    if (defs.hasUniqueDefinition(ref.symbol_id, &def))
+    {
+      add_file_link(def.file_id);
+      hasher.add(def.line);
+    }
+  }
+
+  for (const Include& inc : sema.includes)
+  {
+    hasher.add(inc.line);
+    add_file_link(inc.included_file_id);
+  }
+
+  for (const Include& inc : sema.reverse_includes)
+  {
+    hasher.add(inc.line);
+    add_file_link(inc.file_id);
+  }
+
+  return hasher.value();
+}
+
+void export_html(Snapshot& snapshot, File& file, OutputSink& output, const std::filesystem::path& outputpath, const SymbolTable& symbols, const DefinitionTable& defs, PathResolver& pathresolver, int shard_depth, PageManifest& manifest)
 {
   std::shared_ptr<FileContent> fc = snapshot.getFileContent(file.id);
 
@@ -39,25 +107,15 @@ void export_html(Snapshot& snapshot, File& file, const std::filesystem::path& ou
 
   remove_implicit_references(sema.references);
 
-  FileBrowserGenerator::SymbolMap symbols;
-
-  {
-    std::set<SymbolId> ids;
-
-    for (const SymbolReference& ref : sema.references)
-    {
-      ids.insert(SymbolId(ref.symbol_id));
+  simplify_ctor_and_class_references(sema.references, symbols);
 
-      if (ref.parent_symbol_id.valid())
-      {
-        ids.insert(ref.parent_symbol_id);
-      }
-    }
+  std::string pagepath = outputpath.generic_u8string();
+  uint64_t hash = file_page_hash(*fc, sema, pagepath, snapshot.files(), symbols, defs, pathresolver, shard_depth);
 
-    snapshot.loadSymbols(ids, symbols);
-  }
+  manifest.update(pagepath, hash);
 
-  simplify_ctor_and_class_references(sema.references, symbols);
+  if (manifest.isUpToDate(pagepath, hash))
+    return;
 
   std::stringstream outstrstream;
   XmlWriter xml{ outstrstream };
@@ -65,10 +123,15 @@ void export_html(Snapshot& snapshot, File& file, const std::filesystem::path& ou
   HtmlPage page{ outputpath, xml };
   page.links().setPathResolver(pathresolver);
 
-  FileBrowserGenerator generator{ page, *fc, std::move(sema), snapshot.files(), symbols, defs };
+  auto tokens = std::make_shared<FileTokens>(fc);
+
+  FileBrowserGenerator generator{ page, tokens, std::move(sema), snapshot.files(), symbols, defs };
+  generator.setSymbolShardDepth(shard_depth);
   generator.generatePage();
 
-  write_file(outputdir / outputpath, outstrstream.str());
+  xml.flush();
+
+  output.write(pagepath, outstrstream.str());
 }
 
 static std::set<std::filesystem::path> list_directories(const std::map<File*, std::filesystem::path>& paths)
@@ -112,19 +175,134 @@ static std::set<std::filesystem::path> list_directories_recursive(const std::map
   return result;
 }
 
-static void export_symbol(Snapshot& snapshot, const Symbol& symbol, const std::filesystem::path& outputdir, const std::filesystem::path& outputpath, PathResolver& pathresolver)
+/**
+ * \brief provides the hash of the content of the files of a snapshot
+ * 
+ * Hashes are computed on demand and kept for the whole export.
+ */
+class FileContentHashes
 {
+public:
+  Snapshot& snapshot;
+
+private:
+  std::unordered_map<int64_t, uint64_t> m_hashes;
+
+public:
+  explicit FileContentHashes(Snapshot& s) :
+    snapshot(s)
+  {
+
+  }
+
+  uint64_t get(FileId id)
+  {
+    auto it = m_hashes.find(id.value());
+
+    if (it != m_hashes.end())
+      return it->second;
+
+    InputHasher hasher;
+
+    if (std::shared_ptr<FileContent> fc = snapshot.getFileContent(id))
+      hasher.add(fc->content);
+
+    m_hashes[id.value()] = hasher.value();
+    return hasher.value();
+  }
+};
+
+/**
+ * \brief computes the hash of the inputs of a symbol page
+ * 
+ * The inputs are the symbol itself, the name of its parent, bases and 
+ * derived classes, its references and the content and path of the files 
+ * in which they appear.
+ */
+static uint64_t symbol_page_hash(Snapshot& snapshot, const Symbol& symbol, const std::vector<SymbolReference>& refs, const std::string& outputpath, const SymbolTable& symbols, FileContentHashes& contents, PathResolver& pathresolver, int shard_depth)
+{
+  InputHasher hasher;
+  hasher.add(generator_version()).add(outputpath).add(shard_depth);
+  hasher.add(symbol.name).add(static_cast<int>(symbol.kind)).add(symbol.usr).add(symbol.display_name).add(symbol.flags);
+
+  auto add_symbol_link = [&](SymbolId id) {
+    hasher.add(id.value()).add(symbols.contains(id) ? symbols.name(id) : std::string_view());
+  };
+
+  add_symbol_link(symbol.parent_id);
+
+  if (symbol.kind == Whatsit::CXXClass || symbol.kind == Whatsit::Struct)
+  {
+    for (const BaseClass& base : snapshot.listBaseClasses(symbol.id))
+    {
+      hasher.add(static_cast<int>(base.access_specifier));
+      add_symbol_link(base.base_id);
+    }
+
+    for (SymbolId derived : snapshot.listDerivedClasses(symbol.id))
+      add_symbol_link(derived);
+  }
+
+  FileId current_file;
+
+  for (const SymbolReference& ref : refs)
+  {
+    if (ref.file_id != current_file)
+    {
+      current_file = ref.file_id;
+
+      const File* f = snapshot.files().get(current_file);
+      hasher.add(current_file.value());
+      hasher.add(f ? f->path : std::string()).add(f ? pathresolver.filePath(*f).generic_u8string() : std::string());
+      hasher.add(static_cast<int64_t>(contents.get(current_file)));
+    }
+
+    hasher.add(ref.line).add(ref.col).add(ref.flags);
+  }
+
+  return hasher.value();
+}
+
+static void export_symbol(Snapshot& snapshot, const Symbol& symbol, std::vector<SymbolReference> refs, OutputSink& output, const std::filesystem::path& outputpath, const SymbolTable& symbols, FileTokensCache& tokens, PathResolver& pathresolver, int shard_depth, FileContentHashes& contents, PageManifest& manifest)
+{
+  std::string pagepath = outputpath.generic_u8string();
+  uint64_t hash = symbol_page_hash(snapshot, symbol, refs, pagepath, symbols, contents, pathresolver, shard_depth);
+
+  manifest.update(pagepath, hash);
+
+  if (manifest.isUpToDate(pagepath, hash))
+    return;
+
   std::stringstream outstrstream;
   XmlWriter xml{ outstrstream };
 
   HtmlPage page{ outputpath, xml };
-  SymbolPageGenerator pagegen{ page, snapshot, symbol };
+  SymbolPageGenerator pagegen{ page, snapshot, symbol, std::move(refs) };
 
   pagegen.setPathResolver(pathresolver);
+  pagegen.setSymbolTable(symbols);
+  pagegen.setTokensCache(tokens);
+  pagegen.setSymbolShardDepth(shard_depth);
 
   pagegen.writePage();
 
-  write_file(outputdir / outputpath, outstrstream.str());
+  xml.flush();
+
+  output.write(pagepath, outstrstream.str());
+}
+
+/**
+ * \brief sets the memory budget of the caches of a snapshot
+ * \param snapshot  the snapshot
+ * \param bytes     the total budget, in bytes
+ * 
+ * Most of the budget goes to the file contents, which are much larger 
+ * than symbols.
+ */
+static void set_cache_budget(Snapshot& snapshot, size_t bytes)
+{
+  snapshot.fileContentCache().setBudget(bytes / 4 * 3);
+  snapshot.symbolCache().setBudget(bytes / 4);
 }
 
 class SnapshotExporterHtmlPathResolver : public PathResolver
@@ -179,13 +357,58 @@ void SnapshotExporter::run()
   if (rootpath == "%auto%")
     detectRootPath();
 
-  export_resources_html_assets(outputdir);
+  if (cache_size)
+    set_cache_budget(snapshot, cache_size);
+
+  m_manifest.clear();
+
+  if (archive.empty())
+  {
+    m_output = std::make_unique<DirectorySink>(outputdir);
+
+    if (incremental)
+      m_manifest.load(outputdir / PageManifest::FileName);
+  }
+  else
+  {
+    m_output = std::make_unique<TarSink>(archive);
+  }
 
-  std::map<File*, std::filesystem::path> paths = writeFilePages();
+  export_resources_html_assets(*m_output);
+
+  SymbolTable symbols = snapshot.loadSymbolTable();
+
+  std::map<File*, std::filesystem::path> paths = writeFilePages(symbols);
 
   writeDirectoryPages(paths);
 
-  writeSymbolPages();
+  writeSymbolPages(symbols);
+
+  m_output->close();
+  m_output.reset();
+
+  if (archive.empty())
+  {
+    removeStalePages();
+    m_manifest.save(outputdir / PageManifest::FileName);
+  }
+}
+
+/**
+ * \brief deletes the pages of the previous export that are no longer part of the export
+ */
+void SnapshotExporter::removeStalePages()
+{
+  std::vector<std::string> pages = m_manifest.stalePages();
+
+  for (const std::string& p : pages)
+  {
+    std::error_code ec;
+    std::filesystem::remove(outputdir / std::filesystem::u8path(p), ec);
+  }
+
+  if (!pages.empty())
+    std::cout << "Removed " << pages.size() << " stale page(s)" << std::endl;
 }
 
 void SnapshotExporter::detectRootPath()
@@ -223,7 +446,45 @@ void SnapshotExporter::detectRootPath()
   std::cout << "exporter root path detected: " << rootpath << std::endl;
 }
 
-std::map<File*, std::filesystem::path> SnapshotExporter::writeFilePages()
+/**
+ * \brief helper class that prints the progress of the file pages generation
+ * 
+ * Pages may be completed out of order by the worker threads, but 
+ * progress lines are always printed in the order of the file list.
+ */
+class FilePagesProgress
+{
+public:
+  const std::vector<File*>& files;
+
+private:
+  std::mutex m_mutex;
+  std::vector<bool> m_done;
+  size_t m_next = 0;
+
+public:
+  explicit FilePagesProgress(const std::vector<File*>& fs) :
+    files(fs),
+    m_done(fs.size(), false)
+  {
+
+  }
+
+  void markDone(size_t i)
+  {
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    m_done[i] = true;
+
+    while (m_next < m_done.size() && m_done[m_next])
+    {
+      std::cout << "[" << (m_next + 1) << "/" << files.size() << "] " << files.at(m_next)->path << std::endl;
+      ++m_next;
+    }
+  }
+};
+
+std::map<File*, std::filesystem::path> SnapshotExporter::writeFilePages(const SymbolTable& symbols)
 {
   DefinitionTable defs;
   defs.build(select_symboldefinition(snapshot.database()));
@@ -233,16 +494,84 @@ std::map<File*, std::filesystem::path> SnapshotExporter::writeFilePages()
   std::vector<File*> files = snapshot.files().all();
 
   std::map<File*, std::filesystem::path> result;
-  
-  for (size_t i(0); i < files.size(); ++i)
+  std::vector<std::filesystem::path> savepaths;
+  savepaths.reserve(files.size());
+
+  for (File* f : files)
+  {
+    savepaths.push_back(pathresolver.filePath(*f));
+    result[f] = savepaths.back();
+  }
+
+  FilePagesProgress progress{ files };
+
+  std::filesystem::path dbpath = snapshot.database().path();
+  size_t nbworkers = std::min(nb_threads, files.size());
+
+  if (nbworkers <= 1 || dbpath.empty())
   {
-    File* f = files.at(i);
-    std::cout << "[" << (i + 1) << "/" << files.size() << "] " << f->path << std::endl;
-    std::filesystem::path savepath = pathresolver.filePath(*f);
-    result[f] = savepath;
-    export_html(snapshot, *f, outputdir, savepath, defs, pathresolver);
+    for (size_t i(0); i < files.size(); ++i)
+    {
+      export_html(snapshot, *files.at(i), *m_output, savepaths.at(i), symbols, defs, pathresolver, symbol_shard_depth, m_manifest);
+      progress.markDone(i);
+    }
+
+    return result;
   }
 
+  // the symbol table, the definition table and the path resolver are shared (read-only) 
+  // between the workers, but each worker has its own snapshot so that 
+  // database connections and caches are not shared.
+
+  std::atomic<size_t> next_file{ 0 };
+  std::mutex error_mutex;
+  std::exception_ptr error;
+
+  auto worker = [&]() {
+    try
+    {
+      Snapshot view = Snapshot::open(dbpath);
+
+      if (cache_size)
+        set_cache_budget(view, cache_size / nbworkers);
+
+      for (size_t i = next_file++; i < files.size(); i = next_file++)
+      {
+        File* f = view.getFile(files.at(i)->id);
+
+        if (f)
+          export_html(view, *f, *m_output, savepaths.at(i), symbols, defs, pathresolver, symbol_shard_depth, m_manifest);
+
+        progress.markDone(i);
+      }
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock{ error_mutex };
+
+      if (!error)
+        error = std::current_exception();
+
+      // make the other workers stop
+      next_file = files.size();
+    }
+  };
+
+  std::vector<std::thread> threads;
+
+  for (size_t i(0); i < nbworkers; ++i)
+  {
+    threads.emplace_back(worker);
+  }
+
+  for (std::thread& t : threads)
+  {
+    t.join();
+  }
+
+  if (error)
+    std::rethrow_exception(error);
+
   return result;
 }
 
@@ -267,13 +596,42 @@ void SnapshotExporter::writeDirectoryPages(const std::map<File*, std::filesystem
     DirectoryPageGenerator gen{ page, paths, dirpath };
     gen.writePage();
 
-    write_file(outputdir / page.url().path(), outstrstream.str());
+    xml.flush();
+
+    // directory pages are cheap to generate, their hash is the hash of their content
+    std::string pagepath = page.url().path().generic_u8string();
+    std::string content = outstrstream.str();
+    uint64_t hash = InputHasher().add(content).value();
+
+    if (!m_manifest.isUpToDate(pagepath, hash))
+      m_output->write(pagepath, content);
+
+    m_manifest.update(pagepath, hash);
   }
 }
 
-void SnapshotExporter::writeSymbolPages()
+/**
+ * \brief writes the pages of all symbols
+ * 
+ * Symbols and symbol references are both enumerated ordered by symbol id, 
+ * so that the whole export is done in a single pass over the 
+ * symbolreference table; each page is written as soon as all the 
+ * references to its symbol have been read.
+ */
+void SnapshotExporter::writeSymbolPages(const SymbolTable& symbols)
 {
+  SnapshotExporterHtmlPathResolver pathresolver{ rootpath };
+
+  // files are tokenized once and shared by the pages of all the symbols 
+  // used in them
+  FileTokensCache tokens{ snapshot, cache_size ? cache_size / 2 : FileTokensCache::DefaultBudget };
+
+  FileContentHashes contents{ snapshot };
+
   SymbolEnumerator symenumerator{ snapshot };
+  SymbolReferenceEnumerator refenumerator{ snapshot };
+
+  bool has_ref = refenumerator.next();
 
   while (symenumerator.next())
   {
@@ -281,9 +639,20 @@ void SnapshotExporter::writeSymbolPages()
    
     std::cout << symbol.display_name << std::endl;
 
-    SnapshotExporterHtmlPathResolver pathresolver{ rootpath };
-    std::string outputpath = "symbols/" + SourceHighlighter::symbol_symref(symbol) + ".html";
-    export_symbol(snapshot, symbol, outputdir, outputpath, pathresolver);
+    // skip references to symbols that do not exist
+    while (has_ref && refenumerator.reference.symbol_id < symbol.id)
+      has_ref = refenumerator.next();
+
+    std::vector<SymbolReference> refs;
+
+    while (has_ref && refenumerator.reference.symbol_id == symbol.id)
+    {
+      refs.push_back(refenumerator.reference);
+      has_ref = refenumerator.next();
+    }
+
+    std::string outputpath = SourceHighlighter::symbol_page(symbol.id, symbol_shard_depth);
+    export_symbol(snapshot, symbol, std::move(refs), *m_output, outputpath, symbols, tokens, pathresolver, symbol_shard_depth, contents, m_manifest);
   }
 }
 
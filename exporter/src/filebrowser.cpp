@@ -9,11 +9,31 @@
 namespace csnap
 {
 
-FileBrowserGenerator::FileBrowserGenerator(HtmlPage& p, const FileContent& fc, FileSema fm, const FileList& fs, const SymbolMap& ss, const DefinitionTable& defs) :
-  SourceHighlighter(p, fc, fm, fs, ss, defs)
+FileBrowserGenerator::FileBrowserGenerator(HtmlPage& p, std::shared_ptr<const FileTokens> ft, FileSema fm, const FileList& fs, const SymbolTable& ss, const DefinitionTable& defs) :
+  SourceHighlighter(p, std::move(ft), std::move(fm), fs, ss, defs)
 {
 }
 
+/**
+ * \brief returns the number of levels of sub-directories used for the symbol pages
+ */
+int FileBrowserGenerator::symbolShardDepth() const
+{
+  return m_shard_depth;
+}
+
+/**
+ * \brief sets the number of levels of sub-directories used for the symbol pages
+ * \param depth  the depth
+ * 
+ * The depth is written in the page so that codenav.js can build 
+ * links to the symbol pages.
+ */
+void FileBrowserGenerator::setSymbolShardDepth(int depth)
+{
+  m_shard_depth = depth;
+}
+
 void FileBrowserGenerator::generatePage()
 {
   page.write("<!DOCTYPE html>\n");
@@ -45,6 +65,7 @@ void FileBrowserGenerator::generatePage()
         { "type", "text/javascript" }
         });
       page << "var csnapRootPath=\"" << page.url().pathToRoot() << "\";";
+      page << "var csnapSymbolShardDepth=" << m_shard_depth << ";";
       html::endscript(page);
 
       html::script(page, {
@@ -102,7 +123,7 @@ void FileBrowserGenerator::generate()
     html::endh2(page);
 
     html::table(page, { {"class", "code"} });
-    page.xml.writeAttribute("file-id", sema.file->id.value());
+    page.xml.writeAttribute("file-id", std::to_string(sema.file->id.value()));
     {
       html::tbody(page);
       writeCode();
@@ -14,7 +14,8 @@ namespace csnap
  * \param url  the url of the html page being written
  */
 FilePageLinker::FilePageLinker(PageURL url) : 
-  m_url(std::move(url))
+  m_url(std::move(url)),
+  m_url_path(m_url.path().generic_u8string())
 {
 
 }
@@ -33,6 +34,8 @@ const PageURL& FilePageLinker::currentPageUrl() const
 void FilePageLinker::setCurrentPageUrl(PageURL url)
 {
   m_url = std::move(url);
+  m_url_path = m_url.path().generic_u8string();
+  m_file_links.clear();
 }
 
 /**
@@ -49,6 +52,7 @@ PathResolver* FilePageLinker::pathResolver() const
 void FilePageLinker::setPathResolver(PathResolver& resolver)
 {
   m_path_resolver = &resolver;
+  m_file_links.clear();
 }
 
 /**
@@ -57,13 +61,23 @@ void FilePageLinker::setPathResolver(PathResolver& resolver)
  * 
  * A valid PathResolver must have been specified using setPathResolver() 
  * before calling this function.
+ * 
+ * Links are computed once per file and then cached, as a page usually 
+ * links many times to the same few files.
  */
 std::string FilePageLinker::linkTo(const File& file) const
 {
   assert(pathResolver());
 
-  std::filesystem::path p = pathResolver()->filePath(file);
-  return m_url.linkTo(p);
+  auto it = m_file_links.find(file.id.value());
+
+  if (it != m_file_links.end())
+    return it->second;
+
+  std::string p = pathResolver()->filePath(file).generic_u8string();
+  std::string link = PathResolver::relpath(m_url_path, p);
+  m_file_links[file.id.value()] = link;
+  return link;
 }
 
 /**
@@ -75,7 +89,10 @@ std::string FilePageLinker::linkTo(const File& file) const
  */
 std::string FilePageLinker::linkTo(const File& file, int line) const
 {
-  return linkTo(file) + "#L" + std::to_string(line);
+  std::string link = linkTo(file);
+  link.append("#L");
+  link.append(std::to_string(line));
+  return link;
 }
 
 /**
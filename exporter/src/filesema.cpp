@@ -4,7 +4,7 @@
 
 #include "filesema.h"
 
-#include "csnap/model/symbolmap.h"
+#include <algorithm>
 
 namespace csnap
 {
@@ -14,16 +14,16 @@ inline static bool is_decl_or_def(const SymbolReference& r)
   return r.flags & (SymbolReference::Declaration | SymbolReference::Definition);
 }
 
-static bool swap_if_needed_and_discard_first(SymbolReference& first, SymbolReference& second, const std::map<SymbolId, std::shared_ptr<Symbol>>& symbols)
+static bool swap_if_needed_and_discard_first(SymbolReference& first, SymbolReference& second, const SymbolTable& symbols)
 {
-  std::shared_ptr<Symbol> first_symbol = find_symbol(symbols, SymbolId(first.symbol_id));
-  std::shared_ptr<Symbol> second_symbol = find_symbol(symbols, SymbolId(second.symbol_id));
-
-  if (!first_symbol || !second_symbol)
+  if (!symbols.contains(first.symbol_id) || !symbols.contains(second.symbol_id))
     return false;
 
+  Whatsit first_kind = symbols.kind(first.symbol_id);
+  Whatsit second_kind = symbols.kind(second.symbol_id);
+
   // The following if-elseif could probably be written in a more elegant way...
-  if (first_symbol->kind == Whatsit::CXXConstructor && second_symbol->kind == Whatsit::CXXClass)
+  if (first_kind == Whatsit::CXXConstructor && second_kind == Whatsit::CXXClass)
   {
     if (is_decl_or_def(first))
     {
@@ -32,7 +32,7 @@ static bool swap_if_needed_and_discard_first(SymbolReference& first, SymbolRefer
 
     return true;
   }
-  else if (first_symbol->kind == Whatsit::CXXClass && second_symbol->kind == Whatsit::CXXConstructor)
+  else if (first_kind == Whatsit::CXXClass && second_kind == Whatsit::CXXConstructor)
   {
     if (!is_decl_or_def(second))
     {
@@ -48,7 +48,7 @@ static bool swap_if_needed_and_discard_first(SymbolReference& first, SymbolRefer
 /**
  * \brief simplify references to the class and its constructors at the same location
  * \param refs     the sorted vector of references within a file to process
- * \param symbols  the map of all symbols referenced in 'refs'
+ * \param symbols  a table containing all symbols referenced in 'refs'
  * 
  * To declare a constructor, one cannot avoid referencing the class name.
  * This leads to both a reference to the class and to the constructor being located at 
@@ -64,7 +64,7 @@ static bool swap_if_needed_and_discard_first(SymbolReference& first, SymbolRefer
  * When the constructor is declared or defined, the class reference must be removed; otherwise 
  * the constructor reference must be removed.
  */
-void simplify_ctor_and_class_references(std::vector<SymbolReference>& refs, const std::map<SymbolId, std::shared_ptr<Symbol>>& symbols)
+void simplify_ctor_and_class_references(std::vector<SymbolReference>& refs, const SymbolTable& symbols)
 {
   auto read = refs.begin();
   auto write = read;
@@ -105,4 +105,58 @@ void simplify_ctor_and_class_references(std::vector<SymbolReference>& refs, cons
   }
 }
 
+template<typename T>
+static std::vector<size_t> build_line_table(const std::vector<T>& elements)
+{
+  int maxline = elements.empty() ? 0 : elements.back().line;
+
+  std::vector<size_t> table;
+  table.resize(static_cast<size_t>(maxline) + 2, elements.size());
+
+  // elements are sorted by line, fill the table backwards
+  size_t i = elements.size();
+  int l = maxline + 1;
+
+  while (l >= 0)
+  {
+    while (i > 0 && elements[i - 1].line >= l)
+      --i;
+
+    table[static_cast<size_t>(l)] = i;
+    --l;
+  }
+
+  return table;
+}
+
+/**
+ * \brief builds the per-line tables of a FileSema
+ * \param sema  the file sema
+ * 
+ * This function sorts the references and includes by line (if they 
+ * are not already sorted) and then fills \a references_by_line and 
+ * \a includes_by_line in linear time.
+ * 
+ * It must be called again if the references or includes are modified.
+ */
+void index_lines(FileSema& sema)
+{
+  auto ref_less = [](const SymbolReference& a, const SymbolReference& b) {
+    return std::make_pair(a.line, a.col) < std::make_pair(b.line, b.col);
+  };
+
+  if (!std::is_sorted(sema.references.begin(), sema.references.end(), ref_less))
+    std::stable_sort(sema.references.begin(), sema.references.end(), ref_less);
+
+  auto incl_less = [](const Include& a, const Include& b) {
+    return a.line < b.line;
+  };
+
+  if (!std::is_sorted(sema.includes.begin(), sema.includes.end(), incl_less))
+    std::stable_sort(sema.includes.begin(), sema.includes.end(), incl_less);
+
+  sema.references_by_line = build_line_table(sema.references);
+  sema.includes_by_line = build_line_table(sema.includes);
+}
+
 } // namespace csnap
@@ -0,0 +1,126 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#include "filetokens.h"
+
+#include <csnap/database/snapshot.h>
+
+#include <cpptok/tokenizer.h>
+
+namespace csnap
+{
+
+static FileTokens::Kind token_kind(const cpptok::Token& tok)
+{
+  if (tok.isKeyword())
+    return FileTokens::Keyword;
+  else if (tok.isIdentifier())
+    return FileTokens::Identifier;
+  else if (tok.isOperator())
+    return FileTokens::Operator;
+  else if (tok.isPunctuator())
+    return FileTokens::Punctuator;
+  else if (tok.isComment())
+    return FileTokens::Comment;
+  else if (tok.type() == cpptok::TokenType::Preproc)
+    return FileTokens::Preproc;
+  else if (tok.type() == cpptok::TokenType::Include)
+    return FileTokens::Include;
+  else if (tok.isLiteral())
+    return FileTokens::Literal;
+  else
+    return FileTokens::Other;
+}
+
+/**
+ * \brief tokenizes a file
+ * \param fc  the content of the file
+ */
+FileTokens::FileTokens(std::shared_ptr<FileContent> fc) :
+  m_content(std::move(fc))
+{
+  const std::vector<std::string_view>& lines = m_content->lines;
+  const char* base = m_content->content.data();
+
+  m_tokens.reserve(m_content->content.size() / 4);
+  m_lines.reserve(lines.size() + 1);
+
+  // the tokenizer keeps its state from one line to the next, 
+  // e.g. for multi-line comments
+  cpptok::Tokenizer lexer;
+
+  for (std::string_view line : lines)
+  {
+    m_lines.push_back(static_cast<uint32_t>(m_tokens.size()));
+
+    lexer.output.clear();
+    lexer.tokenize(line.data(), line.size());
+
+    for (const cpptok::Token& tok : lexer.output)
+    {
+      Token t;
+      t.offset = static_cast<uint32_t>(tok.text().data() - base);
+      t.length = static_cast<uint32_t>(tok.text().length());
+      t.kind = token_kind(tok);
+      m_tokens.push_back(t);
+    }
+  }
+
+  m_lines.push_back(static_cast<uint32_t>(m_tokens.size()));
+  m_tokens.shrink_to_fit();
+}
+
+/**
+ * \brief returns an estimate of the memory used by the tokens
+ * 
+ * This includes the content of the file, which is kept alive by this object.
+ */
+size_t FileTokens::memoryUsage() const
+{
+  return sizeof(FileTokens) + m_tokens.capacity() * sizeof(Token) + m_lines.capacity() * sizeof(uint32_t)
+    + m_content->content.capacity() + m_content->lines.capacity() * sizeof(std::string_view);
+}
+
+/**
+ * \brief constructs a cache of tokenized files
+ * \param s       the snapshot from which the files are read
+ * \param budget  the memory budget of the cache, in bytes
+ */
+FileTokensCache::FileTokensCache(Snapshot& s, size_t budget) :
+  m_snapshot(s),
+  m_data(budget)
+{
+
+}
+
+/**
+ * \brief returns the tokens of a file
+ * \param id  the id of the file
+ * 
+ * Returns nullptr if the content of the file is not available.
+ */
+std::shared_ptr<const FileTokens> FileTokensCache::get(FileId id)
+{
+  if (std::shared_ptr<FileTokens> tokens = m_data.find(id.value()))
+    return tokens;
+
+  std::shared_ptr<FileContent> content = m_snapshot.getFileContent(id);
+
+  if (!content)
+    return nullptr;
+
+  auto tokens = std::make_shared<FileTokens>(content);
+  m_data.insert(id.value(), tokens, tokens->memoryUsage());
+  return tokens;
+}
+
+/**
+ * \brief returns the hit, miss and eviction counters of the cache
+ */
+const CacheStats& FileTokensCache::stats() const
+{
+  return m_data.stats();
+}
+
+} // namespace csnap
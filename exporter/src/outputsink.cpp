@@ -0,0 +1,97 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#include "outputsink.h"
+
+#include <fstream>
+
+namespace csnap
+{
+
+/**
+ * \brief virtual destructor
+ */
+OutputSink::~OutputSink()
+{
+
+}
+
+/**
+ * \fn virtual void write(const std::string& path, const std::string& content) = 0
+ * \brief writes a file
+ * \param path     the path of the file, relative to the root of the export
+ * \param content  the binary content of the file
+ * 
+ * If a file with the same path was already written, it is overwritten.
+ */
+
+/**
+ * \brief finishes writing the output
+ * 
+ * No files can be written after this function has been called.
+ * The default implementation does nothing.
+ */
+void OutputSink::close()
+{
+
+}
+
+/**
+ * \brief constructs a sink writing in a directory
+ * \param dir  the directory
+ */
+DirectorySink::DirectorySink(std::filesystem::path dir) :
+  m_directory(std::move(dir))
+{
+
+}
+
+/**
+ * \brief returns the directory in which the files are written
+ */
+const std::filesystem::path& DirectorySink::directory() const
+{
+  return m_directory;
+}
+
+/**
+ * \brief writes a file on disk
+ * \param path     the path of the file, relative to directory()
+ * \param content  the binary content of the file
+ * 
+ * Missing directories are created.
+ */
+void DirectorySink::write(const std::string& path, const std::string& content)
+{
+  std::filesystem::path p = m_directory / std::filesystem::u8path(path);
+
+  createParentDirectory(p);
+
+  std::ofstream file{ p, std::ios::binary | std::ios::trunc };
+  file.write(content.data(), content.size());
+}
+
+/**
+ * \brief creates the directory containing a file if it does not exist
+ * \param p  the path of the file
+ * 
+ * Directories that were already created (or seen) by the sink are 
+ * remembered so that the filesystem is queried only once per directory.
+ */
+void DirectorySink::createParentDirectory(const std::filesystem::path& p)
+{
+  std::filesystem::path dir = p.parent_path();
+
+  std::lock_guard<std::mutex> lock{ m_mutex };
+
+  if (m_created_directories.find(dir) != m_created_directories.end())
+    return;
+
+  if (!dir.empty() && !std::filesystem::exists(dir))
+    std::filesystem::create_directories(dir);
+
+  m_created_directories.insert(dir);
+}
+
+} // namespace csnap
@@ -0,0 +1,181 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#include "pagemanifest.h"
+
+#include "csnap/model/hash.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace csnap
+{
+
+/**
+ * \brief adds a string to the hash
+ * \param str  the string
+ */
+InputHasher& InputHasher::add(std::string_view str)
+{
+  add(static_cast<int64_t>(str.size()));
+  addBytes(str.data(), str.size());
+  return *this;
+}
+
+/**
+ * \brief adds an integer to the hash
+ * \param n  the integer
+ */
+InputHasher& InputHasher::add(int64_t n)
+{
+  auto u = static_cast<uint64_t>(n);
+
+  unsigned char bytes[8];
+
+  for (int i = 0; i < 8; ++i)
+    bytes[i] = static_cast<unsigned char>(u >> (8 * i));
+
+  addBytes(bytes, sizeof(bytes));
+  return *this;
+}
+
+/**
+ * \brief returns the hash of the values added so far
+ */
+uint64_t InputHasher::value() const
+{
+  return m_value;
+}
+
+void InputHasher::addBytes(const void* data, size_t n)
+{
+  m_value = fnv1a_64(std::string_view(static_cast<const char*>(data), n), m_value);
+}
+
+/**
+ * \brief the name of the manifest file, in the output directory of an export
+ */
+const char* PageManifest::FileName = ".csnap-manifest";
+
+static const char* ManifestHeader = "csnap-manifest 1";
+
+/**
+ * \brief loads the manifest of a previous export
+ * \param file  the path of the manifest
+ * 
+ * If the file does not exist or is not a valid manifest, the previous 
+ * export is considered empty and all pages will be regenerated.
+ */
+void PageManifest::load(const std::filesystem::path& file)
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+
+  m_previous.clear();
+  m_current.clear();
+
+  std::ifstream stream{ file };
+
+  if (!stream.is_open())
+    return;
+
+  std::string line;
+
+  if (!std::getline(stream, line) || line != ManifestHeader)
+    return;
+
+  // each line is made of 16 hexadecimal digits, a space and the path of the page
+  while (std::getline(stream, line))
+  {
+    if (line.size() < 18 || line.at(16) != ' ' || line.find_first_not_of("0123456789abcdef") < 16)
+      continue;
+
+    uint64_t hash = std::stoull(line.substr(0, 16), nullptr, 16);
+    m_previous[line.substr(17)] = hash;
+  }
+}
+
+/**
+ * \brief writes the pages recorded with update() in a file
+ * \param file  the path of the manifest
+ */
+void PageManifest::save(const std::filesystem::path& file) const
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+
+  std::ofstream stream{ file, std::ios::binary | std::ios::trunc };
+
+  stream << ManifestHeader << "\n";
+
+  char hex[17];
+
+  for (const auto& p : m_current)
+  {
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(p.second));
+    stream << hex << " " << p.first << "\n";
+  }
+}
+
+/**
+ * \brief removes all pages from the manifest
+ */
+void PageManifest::clear()
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+  m_previous.clear();
+  m_current.clear();
+}
+
+/**
+ * \brief returns whether a page was generated by the previous export with the same inputs
+ * \param page  the path of the page
+ * \param hash  the hash of the current inputs of the page
+ */
+bool PageManifest::isUpToDate(const std::string& page, uint64_t hash) const
+{
+  // m_previous is not modified after load(), no need to lock
+  auto it = m_previous.find(page);
+  return it != m_previous.end() && it->second == hash;
+}
+
+/**
+ * \brief records a page of the current export
+ * \param page  the path of the page
+ * \param hash  the hash of the inputs of the page
+ * 
+ * This function can be called concurrently from several threads.
+ */
+void PageManifest::update(const std::string& page, uint64_t hash)
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+  m_current[page] = hash;
+}
+
+/**
+ * \brief returns the number of pages recorded with update()
+ */
+size_t PageManifest::size() const
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+  return m_current.size();
+}
+
+/**
+ * \brief returns the pages of the previous export that were not recorded in the current one
+ */
+std::vector<std::string> PageManifest::stalePages() const
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+
+  std::vector<std::string> result;
+
+  for (const auto& p : m_previous)
+  {
+    if (m_current.find(p.first) == m_current.end())
+      result.push_back(p.first);
+  }
+
+  return result;
+}
+
+} // namespace csnap
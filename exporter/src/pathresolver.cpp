@@ -17,34 +17,42 @@ PathResolver::~PathResolver()
 
 }
 
-std::string PathResolver::relpath(const std::string& source, const std::string& target)
+/**
+ * \brief computes a relative link from a page to another
+ * \param source  the path of the page containing the link
+ * \param target  the path of the page to link to
+ * 
+ * Both paths must be relative, normalized and use '/' as separator.
+ * The computation is purely string-based and never accesses the filesystem.
+ * 
+ * Example:
+ * \code{.cpp}
+ *   PathResolver::relpath("src/a/file.html", "src/b/other.html") == "../b/other.html";
+ * \endcode
+ */
+std::string PathResolver::relpath(std::string_view source, std::string_view target)
 {
-  if (target == source)
-  {
-    size_t n = target.rfind('/');
-
-    if (n == std::string::npos)
-      return target;
-    else
-      return target.substr(n + 1);
-  }
-
+  // length of the longest common prefix made of whole directories
+  size_t common = 0;
   size_t minlen = std::min(source.size(), target.size());
-  size_t i = 0;
 
-  while (i < minlen && target.at(i) == source.at(i)) ++i;
+  for (size_t i(0); i < minlen && target[i] == source[i]; ++i)
+  {
+    if (source[i] == '/')
+      common = i + 1;
+  }
 
-  size_t nbdir = std::count(source.begin() + i, source.end(), '/');
+  size_t nbdir = std::count(source.begin() + common, source.end(), '/');
 
   std::string r;
-  r.reserve(target.size() - i + nbdir * 3);
+  r.reserve(target.size() - common + nbdir * 3);
 
   while (nbdir--)
   {
     r.append("../");
   }
 
-  r.append(target.begin() + i, target.end());
+  r.append(target.begin() + common, target.end());
 
   return r;
 }
@@ -11,6 +11,7 @@
 #include <csnap/model/filelist.h>
 
 #include <array>
+#include <cstdint>
 #include <algorithm>
 #include <filesystem>
 #include <set>
@@ -48,91 +49,82 @@ static std::string get_symbol_symrefs_filename(const Symbol& sym)
   return r;
 }
 
-SourceHighlighter::SourceHighlighter(HtmlPage& p, const FileContent& fc, FileSema fm, const FileList& fs, const SymbolMap& ss, const DefinitionTable& defs) :
+SourceHighlighter::SourceHighlighter(HtmlPage& p, std::shared_ptr<const FileTokens> ft, FileSema fm, const FileList& fs, const SymbolTable& ss, const DefinitionTable& defs) :
   page(p),
-  content(fc),
+  tokens(std::move(ft)),
+  content(tokens->content()),
   sema(std::move(fm)),
   files(fs),
   symbols(ss),
   definitions(defs)
 {
-
+  index_lines(sema);
 }
 
 std::string SourceHighlighter::symbol_symref(const Symbol& sym)
 {
-  return std::to_string(sym.id.value()) + std::string(".") + sym.name;
+  return symbol_symref(sym.id, sym.name);
 }
 
-void SourceHighlighter::writeLineSource(int l)
+/**
+ * \brief returns the path of the page of a symbol
+ * \param id           the id of the symbol
+ * \param shard_depth  the number of levels of sub-directories
+ * 
+ * Symbol pages are spread over \a shard_depth levels of sub-directories 
+ * to avoid having millions of files in a single directory.
+ * Each level is named after one byte of the id, written in hexadecimal and 
+ * starting with the least significant byte (e.g., symbol 0x1234 with a depth 
+ * of 2 is saved as "symbols/34/12/4660.html").
+ * 
+ * The returned path is relative to the output directory.
+ * This must be kept in sync with csnapCodeNav.implSymbolPage() in codenav.js.
+ */
+std::string SourceHighlighter::symbol_page(SymbolId id, int shard_depth)
 {
-  if (l <= 0)
-    return;
-
-  if (m_current_line != l - 1)
-    lexer.reset();
-  else
-    lexer.output.clear();
-
-  const std::vector<std::string_view>& lines = content.lines;
-
-  size_t i = size_t(l) - 1;
+  static const char* hexdigits = "0123456789abcdef";
 
-  if (i >= lines.size())
-    return;
+  auto value = static_cast<uint64_t>(id.value());
 
-  lexer.tokenize(lines.at(i).data(), lines.at(i).size());
+  std::string r = "symbols/";
 
-  // $TODO: the following if/else block could be improved
-  if (m_current_line != l - 1 || !current_line_sema)
+  for (int i = 0; i < shard_depth; ++i)
   {
-    auto incitbegin = std::find_if(sema.includes.begin(), sema.includes.end(), [l](const Include& incl) {
-      return incl.line >= l;
-      });
-    IncludeIterator incit{ incitbegin, incitbegin ==  sema.includes.end() ? incitbegin : std::next(incitbegin) };
-
-    auto refitbegin = std::find_if(sema.references.begin(), sema.references.end(), [l](const SymbolReference& ref) {
-      return ref.line >= l;
-      });
-
-    auto refitend = std::find_if(refitbegin, sema.references.end(), [l](const SymbolReference& ref) {
-      return ref.line > l;
-      });
-
-    ReferenceIterator refit{refitbegin, refitend };
-
-    SemaIterators semaits{ incit, refit };
-    current_line_sema = std::make_unique<SemaIterators>(semaits);
+    auto byte = static_cast<unsigned>((value >> (8 * i)) & 0xFF);
+    r.push_back(hexdigits[byte >> 4]);
+    r.push_back(hexdigits[byte & 0xF]);
+    r.push_back('/');
   }
-  else
-  {
-    auto incitbegin = std::find_if(current_line_sema->include.iterator(), sema.includes.cend(), [l](const Include& incl) {
-      return incl.line >= l;
-      });
 
-    auto incitend = std::find_if(incitbegin, sema.includes.cend(), [l](const Include& incl) {
-      return incl.line > l;
-      });
-
-    IncludeIterator incit{ incitbegin, incitend };
+  r.append(std::to_string(id.value()));
+  r.append(".html");
+  return r;
+}
 
-    auto refitbegin = std::find_if(current_line_sema->reference.iterator(), sema.references.cend(), [l](const SymbolReference& ref) {
-      return ref.line >= l;
-      });
+std::string SourceHighlighter::symbol_symref(SymbolId id, std::string_view name)
+{
+  std::string r = std::to_string(id.value());
+  r.reserve(r.size() + 1 + name.size());
+  r.push_back('.');
+  r.append(name);
+  return r;
+}
 
-    auto refitend = std::find_if(refitbegin, sema.references.cend(), [l](const SymbolReference& ref) {
-      return ref.line > l;
-      });
+void SourceHighlighter::writeLineSource(int l)
+{
+  if (l <= 0)
+    return;
 
-    ReferenceIterator refit{ refitbegin, refitend };
+  size_t i = size_t(l) - 1;
 
-    current_line_sema->include = incit;
-    current_line_sema->reference = refit;
-  }
+  if (i >= tokens->lineCount())
+    return;
 
   m_current_line = l;
 
-  writeLineSource(lexer.output, *current_line_sema);
+  TokenIterator tokit{ tokens->lineBegin(l), tokens->lineEnd(l) };
+  SemaIterators semaits = lineSema(l);
+  writeLineSource(tokit, semaits);
 }
 
 int SourceHighlighter::currentLine() const
@@ -145,14 +137,31 @@ const std::string_view& SourceHighlighter::currentText() const
   return content.lines[currentLine() - 1];
 }
 
+/**
+ * \brief returns iterators over the includes and references of a line
+ * \param l  the line number (starting at 1)
+ * 
+ * This is a constant time operation, see index_lines().
+ */
+SourceHighlighter::SemaIterators SourceHighlighter::lineSema(int l) const
+{
+  auto [incbegin, incend] = line_range(sema.includes_by_line, l);
+  auto [refbegin, refend] = line_range(sema.references_by_line, l);
+
+  IncludeIterator incit{ sema.includes.begin() + incbegin, sema.includes.begin() + incend };
+  ReferenceIterator refit{ sema.references.begin() + refbegin, sema.references.begin() + refend };
+
+  return SemaIterators{ incit, refit };
+}
+
 std::string SourceHighlighter::pathHref(const std::filesystem::path& p) const
 {
   return page.linkTo(p);
 }
 
-std::string SourceHighlighter::tagFromKeyword(const std::string& kw)
+const char* SourceHighlighter::tagFromKeyword(std::string_view kw)
 {
-  static const std::set<std::string> kws = {
+  static const std::set<std::string, std::less<>> kws = {
     "const",
     "bool",
     "void",
@@ -174,6 +183,11 @@ inline static bool is_class(csnap::Whatsit w)
 }
 
 const std::string& SourceHighlighter::cssClass(const Symbol& sym)
+{
+  return cssClass(sym.kind);
+}
+
+const std::string& SourceHighlighter::cssClass(Whatsit kind)
 {
   static const std::string cxxclass = "type cxxclass";
   static const std::string css_enum = "type enum";
@@ -195,7 +209,7 @@ const std::string& SourceHighlighter::cssClass(const Symbol& sym)
   static const std::string css_cxxinterface = "cxxinterface";
   static const std::string empty = "";
 
-  switch (sym.kind)
+  switch (kind)
   {
   case csnap::Whatsit::Typedef:
     return css_typedef;
@@ -240,71 +254,60 @@ const std::string& SourceHighlighter::cssClass(const Symbol& sym)
   }
 }
 
-int SourceHighlighter::getTokCol(std::string_view text, const cpptok::Token& tok)
-{
-  return static_cast<int>(tok.text().data() - text.data());
-}
-
-void SourceHighlighter::insertPrecedingSpaces(std::string_view txt, size_t& col, const cpptok::Token& tok)
+void SourceHighlighter::insertPrecedingSpaces(size_t& col, const FileTokens::Token& tok)
 {
-  int tokcol = getTokCol(txt, tok);
+  auto tokcol = static_cast<size_t>(tokens->column(tok, m_current_line));
 
   while (col < tokcol)
   {
     ++col;
-    page.xml.writeCharacters(" ");
+    page.xml.writeCharacters(" ", 1);
   }
 }
 
-void SourceHighlighter::writeToken(size_t& col, const cpptok::Token& tok)
+void SourceHighlighter::writeToken(size_t& col, const FileTokens::Token& tok)
 {
-  std::string txt = std::string(tok.text().data(), static_cast<int>(tok.text().length()));
+  std::string_view txt = tokens->text(tok);
 
-  if (tok.isKeyword())
+  switch (tok.kind)
   {
-    std::string tag = tagFromKeyword(txt);
-
-    page.xml.writeStartElement(tag);
+  case FileTokens::Keyword:
+    page.xml.writeStartElement(tagFromKeyword(txt));
     page.xml.writeCharacters(txt);
     page.xml.writeEndElement();
-  }
-  else if (tok.isIdentifier() || tok.isOperator() || tok.isPunctuator())
-  {
+    break;
+  case FileTokens::Identifier:
+  case FileTokens::Operator:
+  case FileTokens::Punctuator:
     page.xml.writeCharacters(txt);
-  }
-  else if (tok.isComment())
-  {
+    break;
+  case FileTokens::Comment:
     page.xml.writeStartElement("i");
     page.xml.writeCharacters(txt);
     page.xml.writeEndElement();
-  }
-  else if (tok.type() == cpptok::TokenType::Preproc)
-  {
+    break;
+  case FileTokens::Preproc:
     page.xml.writeStartElement("u");
     page.xml.writeCharacters(txt);
     page.xml.writeEndElement();
-  }
-  else if (tok.type() == cpptok::TokenType::Include)
-  {
+    break;
+  case FileTokens::Include:
     page.xml.writeStartElement("span");
-
     page.xml.writeAttribute("class", "include");
     page.xml.writeCharacters(txt);
-
     page.xml.writeEndElement();
-  }
-  else if (tok.isLiteral())
-  {
+    break;
+  case FileTokens::Literal:
     page.xml.writeStartElement("var");
     page.xml.writeCharacters(txt);
     page.xml.writeEndElement();
-  }
-  else
-  {
+    break;
+  default:
     page.xml.writeCharacters(txt);
+    break;
   }
 
-  col += static_cast<int>(tok.text().length());
+  col += tok.length;
 }
 
 void SourceHighlighter::writeToken(size_t& col, TokenIterator& tokit)
@@ -358,14 +361,21 @@ void SourceHighlighter::writeTokenAnnotated(size_t& col, TokenIterator& tokit, R
   const SymbolReference& symref = *(refit);
 
   SymbolId symbol_id = symref.symbol_id;
-  SymbolPtr symbol = symbols.at(symbol_id);
-  std::string sym_ref = symbol_symref(*symbol);
-  const std::string& css_class = cssClass(*symbol);
 
-  auto do_write_token = [this, &col, &tokit, symbol]() {
+  if (!symbols.contains(symbol_id))
+  {
+    writeToken(col, tokit);
+    return;
+  }
+
+  Whatsit kind = symbols.kind(symbol_id);
+  std::string sym_ref = symbol_symref(symbol_id, symbols.name(symbol_id));
+  const std::string& css_class = cssClass(kind);
+
+  auto do_write_token = [this, &col, &tokit, kind]() {
     writeToken(col, tokit);
     
-    if (symbol && symbol->kind == Whatsit::CXXDestructor)
+    if (kind == Whatsit::CXXDestructor)
     {
       writeToken(col, tokit);
     }
@@ -437,9 +447,9 @@ void SourceHighlighter::writeTokens(size_t& col, TokenIterator& tokit, SemaItera
 {
   while (!tokit.atend())
   {
-    insertPrecedingSpaces(currentText(), col, *tokit);
+    insertPrecedingSpaces(col, *tokit);
 
-    if ((*tokit).type() == cpptok::TokenType::Include && !sema.include.atend() && match(m_current_line, *sema.include))
+    if ((*tokit).kind == FileTokens::Include && !sema.include.atend() && match(m_current_line, *sema.include))
     {
       writeTokenAnnotated(col, tokit, sema.include);
       ++sema.include;
@@ -457,9 +467,8 @@ void SourceHighlighter::writeTokens(size_t& col, TokenIterator& tokit, SemaItera
   }
 }
 
-void SourceHighlighter::writeLineSource(const std::vector<cpptok::Token>& tokens, SemaIterators& sema)
+void SourceHighlighter::writeLineSource(TokenIterator& tokit, SemaIterators& sema)
 {
-  TokenIterator tokit{ tokens.begin(), tokens.end() };
   size_t col = 0;
 
   writeTokens(col, tokit, sema);
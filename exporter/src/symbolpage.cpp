@@ -6,29 +6,19 @@
 
 #include "sourcehighlighter.h"
 
-#include <cpptok/tokenizer.h>
-
 namespace csnap
 {
 
-void extract_decl_and_defs(std::vector<SymbolReference>& refs, std::vector<SymbolReference>& decls, std::vector<SymbolReference>& defs)
+void extract_decl_and_defs(const std::vector<SymbolReference>& refs, std::vector<SymbolReference>& decls, std::vector<SymbolReference>& defs, std::vector<SymbolReference>& uses)
 {
-  auto is_decl_or_def = [](const SymbolReference& r) -> bool {
-    return r.flags & (SymbolReference::Declaration | SymbolReference::Definition);
-  };
-
-  auto it = std::find_if(refs.begin(), refs.end(), is_decl_or_def);
-
-  while (it != refs.end())
+  for (const SymbolReference& r : refs)
   {
-    if (it->flags & SymbolReference::Declaration)
-      decls.push_back(*it);
+    if (r.flags & SymbolReference::Declaration)
+      decls.push_back(r);
+    else if (r.flags & SymbolReference::Definition)
+      defs.push_back(r);
     else
-      defs.push_back(*it);
-
-    it = refs.erase(it);
-
-    it = std::find_if(refs.begin(), refs.end(), is_decl_or_def);
+      uses.push_back(r);
   }
 }
 
@@ -40,6 +30,26 @@ SymbolPageGenerator::SymbolPageGenerator(HtmlPage& p, Snapshot& snap, const Symb
 
 }
 
+/**
+ * \brief constructs a symbol page generator with the references to the symbol
+ * \param p     the html page
+ * \param snap  the snapshot
+ * \param sym   the symbol
+ * \param refs  all references to the symbol, ordered by file and line
+ * 
+ * Use this constructor when the references have already been loaded, 
+ * to avoid querying the database for each symbol.
+ */
+SymbolPageGenerator::SymbolPageGenerator(HtmlPage& p, Snapshot& snap, const Symbol& sym, std::vector<SymbolReference> refs) :
+  page(p),
+  snapshot(snap),
+  symbol(sym),
+  m_references(std::move(refs)),
+  m_references_loaded(true)
+{
+
+}
+
 PathResolver* SymbolPageGenerator::pathResolver() const
 {
   return page.links().pathResolver();
@@ -50,6 +60,66 @@ void SymbolPageGenerator::setPathResolver(PathResolver& resolver)
   page.links().setPathResolver(resolver);
 }
 
+/**
+ * \brief returns the symbol table used to resolve the symbols linked by the page
+ */
+const SymbolTable* SymbolPageGenerator::symbolTable() const
+{
+  return m_symbols;
+}
+
+/**
+ * \brief sets the symbol table used to resolve the symbols linked by the page
+ * \param table  the table
+ * 
+ * If no table is set, the symbols are loaded from the snapshot.
+ */
+void SymbolPageGenerator::setSymbolTable(const SymbolTable& table)
+{
+  m_symbols = &table;
+}
+
+/**
+ * \brief returns the cache used to get the tokens of the files in which the symbol is used
+ */
+FileTokensCache* SymbolPageGenerator::tokensCache() const
+{
+  return m_tokens_cache;
+}
+
+/**
+ * \brief sets the cache used to get the tokens of the files in which the symbol is used
+ * \param cache  the cache
+ * 
+ * Sharing the cache between the pages of several symbols avoids 
+ * tokenizing the same files again and again.
+ * If no cache is set, files are tokenized for each page.
+ */
+void SymbolPageGenerator::setTokensCache(FileTokensCache& cache)
+{
+  m_tokens_cache = &cache;
+}
+
+/**
+ * \brief returns the number of levels of sub-directories used for the symbol pages
+ */
+int SymbolPageGenerator::symbolShardDepth() const
+{
+  return m_shard_depth;
+}
+
+/**
+ * \brief sets the number of levels of sub-directories used for the symbol pages
+ * \param depth  the depth
+ * 
+ * This must match the depth used to save the pages.
+ * \sa SourceHighlighter::symbol_page().
+ */
+void SymbolPageGenerator::setSymbolShardDepth(int depth)
+{
+  m_shard_depth = depth;
+}
+
 void SymbolPageGenerator::writePage()
 {
   page.xml.write("<!DOCTYPE html>\n");
@@ -88,9 +158,8 @@ void SymbolPageGenerator::writeBody()
 
   writeSummary();
 
-  std::vector<SymbolReference> refs = snapshot.listReferences(symbol.id);
-  std::vector<SymbolReference> decls, defs;
-  extract_decl_and_defs(refs, decls, defs);
+  std::vector<SymbolReference> decls, defs, refs;
+  extract_decl_and_defs(references(), decls, defs, refs);
 
   if (!decls.empty())
   {
@@ -166,23 +235,20 @@ void SymbolPageGenerator::writeSummary()
   }
   html::endp(page);
 
-  if (symbol.parent_id.valid())
-  {
-    std::shared_ptr<Symbol> parent = snapshot.getSymbol(symbol.parent_id);
+  std::string parent_name;
 
-    if (parent)
+  if (symbol.parent_id.valid() && findSymbolName(symbol.parent_id, parent_name))
+  {
+    html::p(page);
     {
-      html::p(page);
-      {
-        page << "Semantic parent: ";
+      page << "Semantic parent: ";
 
-        html::a(page);
-        html::attr(page, "href", SourceHighlighter::symbol_symref(*parent) + ".html");
-        page << parent->name;
-        html::enda(page);
-      }
-      html::endp(page);
+      html::a(page);
+      html::attr(page, "href", symbolHref(symbol.parent_id));
+      page << parent_name;
+      html::enda(page);
     }
+    html::endp(page);
   }
 
   if (symbol.kind == Whatsit::CXXClass || symbol.kind == Whatsit::Struct)
@@ -205,12 +271,13 @@ void SymbolPageGenerator::writeBases()
   {
     page << "Bases: ";
 
+    std::string basename;
+
     for (size_t i(0); i < bases.size(); ++i)
     {
       const BaseClass& base = bases.at(i);
-      std::shared_ptr<Symbol> basesymbol = snapshot.getSymbol(base.base_id);
 
-      if (!basesymbol)
+      if (!findSymbolName(base.base_id, basename))
         continue;
 
       html::a(page);
@@ -230,9 +297,9 @@ void SymbolPageGenerator::writeBases()
         break;
       }
 
-      html::attr(page, "href", SourceHighlighter::symbol_symref(*basesymbol) + ".html");
+      html::attr(page, "href", symbolHref(base.base_id));
 
-      page << basesymbol->name;
+      page << basename;
       html::enda(page);
 
       if (i != bases.size() - 1)
@@ -255,18 +322,18 @@ void SymbolPageGenerator::writeDerivedClasses()
   {
     page << "Known derived classes: ";
 
+    std::string derivedname;
+
     for (size_t i(0); i < derived_classes.size(); ++i)
     {
-      std::shared_ptr<Symbol> basesymbol = snapshot.getSymbol(derived_classes.at(i));
-
-      if (!basesymbol)
+      if (!findSymbolName(derived_classes.at(i), derivedname))
         continue;
 
       html::a(page);
 
-      html::attr(page, "href", SourceHighlighter::symbol_symref(*basesymbol) + ".html");
+      html::attr(page, "href", symbolHref(derived_classes.at(i)));
 
-      page << basesymbol->name;
+      page << derivedname;
       html::enda(page);
 
       page << ((i != derived_classes.size() - 1) ? ", " : ".");
@@ -329,11 +396,22 @@ void SymbolPageGenerator::writeUsesInFile(RefIterator begin, RefIterator end)
   if (!f)
     return;
 
-  std::shared_ptr<FileContent> content = snapshot.getFileContent(f->id);
+  std::shared_ptr<const FileTokens> tokens;
 
-  if (!content)
+  if (m_tokens_cache)
+  {
+    tokens = m_tokens_cache->get(f->id);
+  }
+  else if (std::shared_ptr<FileContent> fc = snapshot.getFileContent(f->id))
+  {
+    tokens = std::make_shared<FileTokens>(fc);
+  }
+
+  if (!tokens)
     return;
 
+  const FileContent& content = tokens->content();
+
   html::h3(page);
   page << f->path << " (" << (int)std::distance(begin, end) << ")";
   html::endh3(page);
@@ -351,12 +429,10 @@ void SymbolPageGenerator::writeUsesInFile(RefIterator begin, RefIterator end)
   }*/
 
 
-  cpptok::Tokenizer lexer;
-
   for (auto it = begin; it != end; ++it)
   {
     const SymbolReference& ref = *it;
-    std::string_view linetext = content->lines.at(ref.line - 1);
+    std::string_view linetext = content.lines.at(ref.line - 1);
 
     html::div(page, { {"class", "use"} });
     {
@@ -379,15 +455,25 @@ void SymbolPageGenerator::writeUsesInFile(RefIterator begin, RefIterator end)
         size_t col = static_cast<size_t>(ref.col) - 1;
         page << linetext.substr(0, col);
 
-        lexer.tokenize(linetext.data() + col, linetext.size() - col);
+        // find the token at the position of the reference
+        size_t toklen = 0;
+
+        for (auto tokit = tokens->lineBegin(ref.line); tokit != tokens->lineEnd(ref.line); ++tokit)
+        {
+          auto tokcol = static_cast<size_t>(tokens->column(*tokit, ref.line));
+
+          if (tokcol <= col && col < tokcol + tokit->length)
+          {
+            toklen = tokcol + tokit->length - col;
+            break;
+          }
+        }
 
         html::span(page, { {"class", "here"} });
-        page << lexer.output.front().text();
+        page << linetext.substr(col, toklen);
         html::endspan(page);
 
-        page << linetext.substr(col + lexer.output.front().text().size());
-
-        lexer.output.clear();
+        page << linetext.substr(col + toklen);
       }
       html::enddiv(page);
     }
@@ -395,4 +481,50 @@ void SymbolPageGenerator::writeUsesInFile(RefIterator begin, RefIterator end)
   }
 }
 
+const std::vector<SymbolReference>& SymbolPageGenerator::references()
+{
+  if (!m_references_loaded)
+  {
+    m_references = snapshot.listReferences(symbol.id);
+    m_references_loaded = true;
+  }
+
+  return m_references;
+}
+
+/**
+ * \brief retrieves the name of a symbol
+ * \param id    the id of the symbol
+ * \param name  output string in which the name is written
+ * \return whether the symbol was found
+ */
+bool SymbolPageGenerator::findSymbolName(SymbolId id, std::string& name)
+{
+  if (m_symbols)
+  {
+    if (!m_symbols->contains(id))
+      return false;
+
+    name.assign(m_symbols->name(id));
+    return true;
+  }
+
+  std::shared_ptr<Symbol> s = snapshot.getSymbol(id);
+
+  if (!s)
+    return false;
+
+  name = s->name;
+  return true;
+}
+
+/**
+ * \brief returns a link to the page of another symbol
+ * \param id  the id of the symbol
+ */
+std::string SymbolPageGenerator::symbolHref(SymbolId id) const
+{
+  return page.url().pathToRoot() + SourceHighlighter::symbol_page(id, m_shard_depth);
+}
+
 } // namespace csnap
@@ -0,0 +1,226 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#include "tarsink.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace csnap
+{
+
+static constexpr size_t TarBlockSize = 512;
+
+// layout of a ustar header, see https://www.gnu.org/software/tar/manual/html_node/Standard.html
+struct TarHeader
+{
+  char name[100];
+  char mode[8];
+  char uid[8];
+  char gid[8];
+  char size[12];
+  char mtime[12];
+  char chksum[8];
+  char typeflag;
+  char linkname[100];
+  char magic[6];
+  char version[2];
+  char uname[32];
+  char gname[32];
+  char devmajor[8];
+  char devminor[8];
+  char prefix[155];
+  char padding[12];
+};
+
+static_assert(sizeof(TarHeader) == TarBlockSize, "unexpected tar header size");
+
+static void write_octal(char* field, size_t width, uint64_t value)
+{
+  // the field is filled with width-1 octal digits followed by a NUL character
+  field[width - 1] = '\0';
+
+  for (size_t i = width - 1; i > 0; --i)
+  {
+    field[i - 1] = static_cast<char>('0' + (value & 7));
+    value >>= 3;
+  }
+}
+
+static void write_string(char* field, size_t width, const std::string& str)
+{
+  std::memcpy(field, str.data(), std::min(width, str.size()));
+}
+
+/**
+ * \brief splits a path in a ustar prefix and name
+ * \param path    the path
+ * \param prefix  receives the prefix
+ * \param name    receives the name
+ * \return whether the path fits in the ustar header
+ */
+static bool split_ustar_path(const std::string& path, std::string& prefix, std::string& name)
+{
+  if (path.size() <= sizeof(TarHeader::name))
+  {
+    prefix.clear();
+    name = path;
+    return true;
+  }
+
+  for (size_t i = path.find('/'); i != std::string::npos; i = path.find('/', i + 1))
+  {
+    if (i > sizeof(TarHeader::prefix))
+      break;
+
+    if (path.size() - i - 1 <= sizeof(TarHeader::name))
+    {
+      prefix = path.substr(0, i);
+      name = path.substr(i + 1);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * \brief creates a tar archive
+ * \param archive  the path of the archive on disk
+ * 
+ * If the file already exists, it is overwritten.
+ * Throws if the file cannot be opened.
+ */
+TarSink::TarSink(const std::filesystem::path& archive) :
+  m_file(archive, std::ios::binary | std::ios::trunc)
+{
+  if (!m_file.is_open())
+    throw std::runtime_error("could not open " + archive.u8string() + " for writing");
+}
+
+/**
+ * \brief destroys the sink
+ * 
+ * The archive is closed if close() has not been called.
+ */
+TarSink::~TarSink()
+{
+  if (!m_closed)
+  {
+    try
+    {
+      close();
+    }
+    catch (...)
+    {
+
+    }
+  }
+}
+
+/**
+ * \brief appends a file to the archive
+ * \param path     the path of the file in the archive
+ * \param content  the binary content of the file
+ * 
+ * Files are not deduplicated: if the same path is written twice, the 
+ * archive contains two entries and the last one wins on extraction.
+ */
+void TarSink::write(const std::string& path, const std::string& content)
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+
+  if (m_closed)
+    throw std::runtime_error("cannot write " + path + ": archive is closed");
+
+  writeHeader(path, content.size(), '0');
+  writeData(content.data(), content.size());
+
+  ++m_count;
+}
+
+/**
+ * \brief writes the end-of-archive marker and closes the file
+ */
+void TarSink::close()
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+
+  if (m_closed)
+    return;
+
+  const std::array<char, 2 * TarBlockSize> end_of_archive = {};
+  m_file.write(end_of_archive.data(), end_of_archive.size());
+  m_file.close();
+
+  m_closed = true;
+}
+
+/**
+ * \brief returns the number of files written in the archive
+ */
+size_t TarSink::count() const
+{
+  return m_count.load();
+}
+
+void TarSink::writeHeader(const std::string& path, size_t size, char type)
+{
+  std::string prefix;
+  std::string name;
+
+  if (!split_ustar_path(path, prefix, name))
+  {
+    // the path is written in a GNU long name entry preceding the actual entry;
+    // the ustar header then contains a truncated name
+    writeHeader("././@LongLink", path.size() + 1, 'L');
+    writeData(path.c_str(), path.size() + 1);
+    prefix.clear();
+    name = path.substr(0, sizeof(TarHeader::name));
+  }
+
+  TarHeader header;
+  std::memset(&header, 0, sizeof(header));
+
+  write_string(header.name, sizeof(header.name), name);
+  write_octal(header.mode, sizeof(header.mode), 0644);
+  write_octal(header.uid, sizeof(header.uid), 0);
+  write_octal(header.gid, sizeof(header.gid), 0);
+  write_octal(header.size, sizeof(header.size), size);
+  write_octal(header.mtime, sizeof(header.mtime), 0);
+  header.typeflag = type;
+  std::memcpy(header.magic, "ustar", 6);
+  std::memcpy(header.version, "00", 2);
+  write_string(header.prefix, sizeof(header.prefix), prefix);
+
+  // the checksum is computed with the checksum field filled with spaces
+  std::memset(header.chksum, ' ', sizeof(header.chksum));
+
+  const auto* bytes = reinterpret_cast<const unsigned char*>(&header);
+  unsigned int checksum = 0;
+
+  for (size_t i = 0; i < sizeof(header); ++i)
+    checksum += bytes[i];
+
+  write_octal(header.chksum, 7, checksum);
+
+  m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void TarSink::writeData(const char* data, size_t size)
+{
+  m_file.write(data, size);
+
+  size_t padding = (TarBlockSize - size % TarBlockSize) % TarBlockSize;
+
+  if (padding)
+  {
+    const std::array<char, TarBlockSize> zeros = {};
+    m_file.write(zeros.data(), padding);
+  }
+}
+
+} // namespace csnap
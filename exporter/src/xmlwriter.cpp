@@ -4,7 +4,12 @@
 
 #include "xmlwriter.h"
 
+#include <array>
 #include <cassert>
+#include <cstring>
+
+// size above which the buffer is written to the output stream
+static constexpr size_t XmlWriterBufferSize = 64 * 1024;
 
 /**
  * \brief constructs a xml writer on an output stream
@@ -17,26 +22,41 @@
 XmlWriter::XmlWriter(OutputStream& output)
   : m_output(output)
 {
+  m_buffer.reserve(XmlWriterBufferSize + 4096);
+}
 
+/**
+ * \brief destroys the writer
+ * 
+ * Remaining buffered output is written to the output stream.
+ */
+XmlWriter::~XmlWriter()
+{
+  flush();
 }
 
 /**
  * \brief returns the writer's output stream
+ * 
+ * Buffered output is written to the stream before it is returned, 
+ * so that bytes written directly to the stream end up in the right place.
  */
 XmlWriter::OutputStream& XmlWriter::stream() const
 {
+  flush();
   return m_output;
 }
 
 /**
- * \brief write bytes to the output stream
- * 
- * \warning Unlike writeCharacters(), this function does not escape 
- * special XML characters like '<'.
+ * \brief writes buffered output to the output stream
  */
-void XmlWriter::write(const std::string& txt)
+void XmlWriter::flush() const
 {
-  stream() << txt;
+  if (m_buffer.empty())
+    return;
+
+  m_output.write(m_buffer.data(), m_buffer.size());
+  m_buffer.clear();
 }
 
 /**
@@ -44,16 +64,37 @@ void XmlWriter::write(const std::string& txt)
  * \param qname  the qualified named of the element
  */
 void XmlWriter::writeStartElement(const std::string& qname)
+{
+  writeStartElement(std::string_view(qname));
+}
+
+/**
+ * \overload void XmlWriter::writeStartElement(const std::string& qname)
+ */
+void XmlWriter::writeStartElement(const char* qname)
+{
+  writeStartElement(std::string_view(qname));
+}
+
+/**
+ * \overload void XmlWriter::writeStartElement(const std::string& qname)
+ */
+void XmlWriter::writeStartElement(std::string_view qname)
 {
   if (withinElement() && !current().attributes_closed)
     sealAttributes();
 
-  m_output << "<" << qname;
+  m_buffer.push_back('<');
+  m_buffer.append(qname.data(), qname.size());
 
+  // element names are stacked in a single string to avoid an 
+  // allocation per element
   Element e;
-  e.name = qname;
+  e.name_offset = m_element_names.size();
+  e.name_size = qname.size();
+  m_element_names.append(qname.data(), qname.size());
 
-  m_elements.push_back(std::move(e));
+  m_elements.push_back(e);
 }
 
 /**
@@ -64,16 +105,23 @@ void XmlWriter::writeStartElement(const std::string& qname)
  */
 void XmlWriter::writeEndElement()
 {
-  if (!m_elements.back().attributes_closed)
+  const Element& e = m_elements.back();
+
+  if (!e.attributes_closed)
   {
-    m_output << "/>";
+    m_buffer.append("/>", 2);
   }
   else
   {
-    m_output << "</" << m_elements.back().name << ">";
+    m_buffer.append("</", 2);
+    m_buffer.append(m_element_names, e.name_offset, e.name_size);
+    m_buffer.push_back('>');
   }
 
+  m_element_names.resize(e.name_offset);
   m_elements.pop_back();
+
+  flushIfFull();
 }
 
 /**
@@ -86,11 +134,15 @@ void XmlWriter::writeEndElement()
  * Specifically, all calls to writeAttribute() must come before calls to writeCharacters()
  * or writeStartElement() (which will open a new element).
  */
-void XmlWriter::writeAttribute(const std::string& name, const std::string& value)
+void XmlWriter::writeAttribute(std::string_view name, std::string_view value)
 {
   assert(!current().attributes_closed);
 
-  m_output << " " << name << "=\"" << value << "\"";
+  m_buffer.push_back(' ');
+  m_buffer.append(name.data(), name.size());
+  m_buffer.append("=\"", 2);
+  m_buffer.append(value.data(), value.size());
+  m_buffer.push_back('"');
 }
 
 /**
@@ -100,7 +152,7 @@ void XmlWriter::writeAttribute(const std::string& name, const std::string& value
  * 
  * This converts the integer to a string an uses the other overload.
  */
-void XmlWriter::writeAttribute(const std::string& name, int value)
+void XmlWriter::writeAttribute(std::string_view name, int value)
 {
   writeAttribute(name, std::to_string(value));
 }
@@ -117,7 +169,7 @@ void XmlWriter::writeAttribute(const std::string& name, int value)
  */
 void XmlWriter::writeCharacters(const std::string& text)
 {
-  writeCharacters(std::string_view(text));
+  writeCharacters(text.data(), text.size());
 }
 
 /**
@@ -128,34 +180,34 @@ void XmlWriter::writeCharacters(std::string_view text)
   writeCharacters(text.data(), text.size());
 }
 
-inline void write_char_escaped(XmlWriter::OutputStream& stream, char c)
+/**
+ * \overload void XmlWriter::writeCharacters(const std::string& text)
+ */
+void XmlWriter::writeCharacters(const char* str)
 {
-  // https://stackoverflow.com/questions/1091945/what-characters-do-i-need-to-escape-in-xml-documents
+  writeCharacters(str, std::strlen(str));
+}
 
+static std::array<bool, 256> build_special_chars()
+{
+  // https://stackoverflow.com/questions/1091945/what-characters-do-i-need-to-escape-in-xml-documents
 
-  if (c == '<')
-    stream << "&lt;";
-  else if (c == '>')
-    stream << "&gt;";
-  else if (c == '&')
-    stream << "&amp;";
-  else
-    stream << c;
+  std::array<bool, 256> r;
+  r.fill(false);
+  r['<'] = true;
+  r['>'] = true;
+  r['&'] = true;
+  return r;
 }
 
-/**
- * \overload void XmlWriter::writeCharacters(const std::string& text)
- */
-void XmlWriter::writeCharacters(const char* str)
+static const std::array<bool, 256> special_chars = build_special_chars();
+
+inline static const char* find_special_char(const char* begin, const char* end)
 {
-  if (withinElement() && !current().attributes_closed)
-    sealAttributes();
+  while (begin != end && !special_chars[(unsigned char)*begin])
+    ++begin;
 
-  while(*str)
-  {
-    char c = *(str++);
-    write_char_escaped(m_output, c);
-  }
+  return begin;
 }
 
 /**
@@ -166,11 +218,35 @@ void XmlWriter::writeCharacters(const char* str, size_t n)
   if (withinElement() && !current().attributes_closed)
     sealAttributes();
 
-  while(n--)
+  const char* end = str + n;
+
+  // copy runs of characters that do not need escaping in one go
+  while (str != end)
   {
-    char c = *(str++);
-    write_char_escaped(m_output, c);
+    const char* special = find_special_char(str, end);
+
+    m_buffer.append(str, special - str);
+
+    if (special == end)
+      break;
+
+    switch (*special)
+    {
+    case '<':
+      m_buffer.append("&lt;", 4);
+      break;
+    case '>':
+      m_buffer.append("&gt;", 4);
+      break;
+    default:
+      m_buffer.append("&amp;", 5);
+      break;
+    }
+
+    str = special + 1;
   }
+
+  flushIfFull();
 }
 
 bool XmlWriter::withinElement() const
@@ -185,7 +261,13 @@ XmlWriter::Element& XmlWriter::current()
 
 void XmlWriter::sealAttributes()
 {
-  m_output << ">";
+  m_buffer.push_back('>');
 
   current().attributes_closed = true;
 }
+
+void XmlWriter::flushIfFull()
+{
+  if (m_buffer.size() >= XmlWriterBufferSize)
+    flush();
+}
@@ -7,12 +7,16 @@
 
 #include "indexer.h"
 
+#include <csnap/model/usrmap.h>
+
 #include <map>
+#include <set>
 
 namespace csnap
 {
 
 class Snapshot;
+class SnapshotWriter;
 
 /**
  * \brief helper class for aggregating indexing results
@@ -21,6 +25,9 @@ class Snapshot;
  * produced while indexing another translation unit (e.g., because both translation 
  * units included the same file).
  * 
+ * The remap() function replaces the symbol ids local to a translation unit by 
+ * global ids and removes symbols that were already produced.
+ * 
  * The reduce() function in this class removes symbol references that are already 
  * known so that no duplicates end up in the database.
  */
@@ -31,10 +38,16 @@ public:
 
   Snapshot& snapshot() const;
 
+  void setWriter(SnapshotWriter* writer);
+
+  void remap(IndexingResult& result);
   void reduce(std::vector<SymbolReference>& references);
 
 private:
   Snapshot& m_snapshot;
+  SnapshotWriter* m_writer = nullptr;
+  UsrMap m_usrs;
+  std::set<SymbolId> m_symbols_with_bases;
 
   struct ReferencesInFileInfo
   {
@@ -12,7 +12,6 @@
 #include <csnap/model/filelist.h>
 #include <csnap/model/include.h>
 #include <csnap/model/reference.h>
-#include <csnap/model/usrmap.h>
 
 #include <libclang-utils/clang-index.h>
 #include <libclang-utils/index-action.h>
@@ -20,6 +19,11 @@
 #include <chrono>
 #include <map>
 #include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace csnap
@@ -47,6 +51,10 @@ struct IndexingResult
 
   /**
    * \brief the list of symbols that were first encountered while indexing the translation unit
+   * 
+   * The indexer produces all the symbols of the translation unit with ids that are 
+   * local to the translation unit; the list is reduced to the new symbols and the ids 
+   * are made global by IndexingResultAggregator::remap().
    */
   std::vector<std::shared_ptr<Symbol>> symbols;
 
@@ -75,10 +83,12 @@ public:
   ~Indexer();
 
   libclang::LibClang& libclangAPI();
-  libclang::IndexAction& indexAction();
 
   Snapshot& snapshot() const;
 
+  size_t threadCount() const;
+  void setThreadCount(size_t n);
+
   void asyncIndex(TranslationUnitParsingResult parsingResult);
 
   bool done() const;
@@ -87,7 +97,8 @@ public:
 
   std::pair<File*, std::unique_ptr<File>> getFile(std::string path);
 
-  GlobalUsrMap& sharedUsrMap();
+  std::unique_ptr<libclang::IndexAction> takeIndexAction();
+  void releaseIndexAction(std::unique_ptr<libclang::IndexAction> action);
 
 public:
   /**
@@ -107,11 +118,15 @@ public:
 private:
   libclang::Index& m_index;
   Snapshot& m_snapshot;
-  std::unique_ptr<libclang::IndexAction> m_index_action;
+  libclang::LibClang* m_libclang = nullptr;
+  size_t m_nb_index_actions = 0;
+  SharedQueue<std::unique_ptr<libclang::IndexAction>> m_index_actions;
   IndexerResultQueue m_results;
-  ThreadPool m_threads;
-  GlobalUsrMap m_usrs;
-  int m_file_id_generator = -1; // used only if collect_new_files is true
+  std::unordered_map<std::string_view, File*> m_known_files; // see getFile()
+  std::shared_mutex m_new_files_mutex;
+  std::unordered_map<std::string, File*> m_new_files;
+  std::unordered_set<int64_t> m_file_ids; // ids of known and new files, guarded by m_new_files_mutex
+  ThreadPool m_threads; // must be destroyed first
 };
 
 } // namespace csnap
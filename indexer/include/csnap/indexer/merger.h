@@ -0,0 +1,54 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#ifndef CSNAP_MERGER_H
+#define CSNAP_MERGER_H
+
+#include "aggregator.h"
+
+#include <csnap/model/usrmap.h>
+
+#include <set>
+
+namespace csnap
+{
+
+class Snapshot;
+
+/**
+ * \brief combines several snapshots into one
+ *
+ * This is typically used to assemble the partial snapshots produced by
+ * scanning a solution in several shards (see Scanner::shard_count).
+ *
+ * Files are matched by path and symbols by USR; the ids of the merged
+ * snapshot are assigned independently of the ids of the input snapshots.
+ * Symbol references that were already merged from another snapshot
+ * are removed using IndexingResultAggregator::reduce().
+ *
+ * Serialized ASTs of translation units are not merged.
+ */
+class SnapshotMerger
+{
+public:
+  explicit SnapshotMerger(Snapshot& output);
+
+  Snapshot& output() const;
+
+  void merge(Snapshot& input);
+
+protected:
+  void writeIfNeeded();
+
+private:
+  Snapshot& m_output;
+  IndexingResultAggregator m_aggregator;
+  UsrMap m_usrs;
+  std::set<SymbolId> m_symbols_with_bases;
+  std::set<TranslationUnitId> m_units_with_includes;
+};
+
+} // namespace csnap
+
+#endif // CSNAP_MERGER_H
@@ -21,6 +21,7 @@ struct SharedQueueSynchronizationData
 {
   std::mutex mutex;
   std::condition_variable cv;
+  std::condition_variable cv_not_full;
 };
 
 } // namespace details
@@ -32,6 +33,10 @@ struct SharedQueueSynchronizationData
  * Please note, however, that the class was designed for a multiple-producers /
  * single-consumer architecture; its API is therefore not that practical 
  * in a multiple-consumers scenario.
+ * 
+ * The queue may optionally have a capacity, in which case write() blocks 
+ * while the queue is full; this can be used to limit the number of elements 
+ * produced in advance by the producers.
  */
 template<typename T>
 class SharedQueue
@@ -49,6 +54,17 @@ public:
 
   }
 
+  /**
+   * \brief constructs a queue with a given capacity
+   * \param capacity  the maximum number of elements, 0 for no limit
+   */
+  explicit SharedQueue(size_t capacity) :
+    m_capacity(capacity),
+    m_synchronization(std::make_unique<details::SharedQueueSynchronizationData>())
+  {
+
+  }
+
   SharedQueue(const SharedQueue&) = delete;
 
   /**
@@ -67,6 +83,10 @@ public:
 
     T n{ std::move(container().front()) };
     container().pop();
+
+    lock.unlock();
+    cvNotFull().notify_one();
+
     return n;
   }
 
@@ -99,15 +119,74 @@ public:
    * 
    * Writing an element may wake-up another thread waiting in next()
    * or waitForNext().
+   * 
+   * If the queue has a capacity and is full, this function waits until 
+   * an element is removed from the queue.
    */
   void write(T val)
+  {
+    {
+      std::unique_lock<std::mutex> lock{ mutex() };
+
+      cvNotFull().wait(lock, [&]() {
+        return !full();
+        });
+
+      container().push(std::move(val));
+    }
+
+    cv().notify_one();
+  }
+
+  /**
+   * \brief tries to append an element to the queue
+   * \param val  the element
+   * \return true if the element was appended, false if the queue is full
+   * 
+   * This function never blocks; \a val is only moved from if the function 
+   * returns true.
+   */
+  bool tryWrite(T& val)
   {
     {
       std::lock_guard<std::mutex> lock{ mutex() };
+
+      if (full())
+        return false;
+
       container().push(std::move(val));
     }
 
     cv().notify_one();
+
+    return true;
+  }
+
+  /**
+   * \brief returns the maximum number of elements in the queue
+   * 
+   * A capacity of 0 means that the queue is unbounded.
+   */
+  size_t capacity() const
+  {
+    std::lock_guard<std::mutex> lock{ mutex() };
+    return m_capacity;
+  }
+
+  /**
+   * \brief sets the maximum number of elements in the queue
+   * \param n  the capacity, 0 for no limit
+   * 
+   * Reducing the capacity does not remove any element from the queue.
+   */
+  void setCapacity(size_t n)
+  {
+    {
+      std::lock_guard<std::mutex> lock{ mutex() };
+      m_capacity = n;
+    }
+
+    cvNotFull().notify_all();
   }
 
   /**
@@ -140,8 +219,12 @@ public:
    */
   void clear()
   {
-    std::lock_guard<std::mutex> lock{ mutex() };
-    container() = {};
+    {
+      std::lock_guard<std::mutex> lock{ mutex() };
+      container() = {};
+    }
+
+    cvNotFull().notify_all();
   }
 
 protected:
@@ -156,6 +239,17 @@ protected:
     return m_synchronization->cv;
   }
 
+  std::condition_variable& cvNotFull() const
+  {
+    return m_synchronization->cv_not_full;
+  }
+
+  // must be called with the mutex locked
+  bool full() const
+  {
+    return m_capacity != 0 && container().size() >= m_capacity;
+  }
+
   std::queue<T>& container()
   {
     return m_queue;
@@ -170,6 +264,7 @@ protected:
 
 private:
   std::queue<T> m_queue;
+  size_t m_capacity = 0;
   std::unique_ptr<details::SharedQueueSynchronizationData> m_synchronization;
 };
 
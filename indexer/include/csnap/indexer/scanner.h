@@ -8,6 +8,7 @@
 #include "csnap/database/snapshot.h"
 
 #include <filesystem>
+#include <vector>
 
 namespace csnap
 {
@@ -20,15 +21,64 @@ class Scanner
 public:
   bool save_ast = false;
   int nb_parsing_threads = 1;
+  int nb_indexing_threads = 1;
+
+  /**
+   * \brief maximum number of parsed translation units waiting to be indexed
+   * 
+   * Each parsed translation unit holds its AST in memory; the parsing threads 
+   * wait while the queue is full.
+   * A value of 0 means that the queue is unbounded.
+   */
+  int parsing_queue_depth = 4;
+
+  /**
+   * \brief index of the shard to scan, in the range [0, shard_count)
+   * 
+   * When shard_count is greater than 1, only the translation units whose 
+   * source file falls into this shard are parsed and indexed; the partial 
+   * snapshots produced for each shard can then be combined with SnapshotMerger.
+   */
+  int shard_index = 0;
+  int shard_count = 1;
+
+  /**
+   * \brief number of worker processes used for parsing and indexing
+   * 
+   * If greater than zero, the translation units are parsed and indexed in 
+   * child processes (see WorkerPool) instead of threads of the current process, 
+   * so that a crash of libclang only loses one translation unit. 
+   * The worker processes run the "worker" command of worker_program.
+   */
+  int nb_workers = 0;
+  std::filesystem::path worker_program;
+
+  /**
+   * \brief time allowed for a worker to process a translation unit, in seconds
+   * 
+   * A value of 0 means that there is no limit.
+   */
+  int worker_timeout = 600;
 
 public:
 
   void initSnapshot(std::filesystem::path& p);
+  void openSnapshot(const std::filesystem::path& p);
+
+  Snapshot& snapshot() const;
 
   void scanSln(const std::filesystem::path& slnPath);
 
+protected:
+  std::vector<TranslationUnit*> prepareUpdate();
+  void indexInProcess(const std::vector<TranslationUnit*>& units);
+  void indexWithWorkers(const std::vector<TranslationUnit*>& units);
+  bool isInShard(const TranslationUnit& tu) const;
+  void sortLongestFirst(std::vector<TranslationUnit*>& units) const;
+
 private:
   std::unique_ptr<Snapshot> m_snapshot;
+  bool m_update = false;
 };
 
 } // namespace csnap
@@ -0,0 +1,21 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#ifndef CSNAP_SERIALIZATION_H
+#define CSNAP_SERIALIZATION_H
+
+#include "indexer.h"
+
+#include <string>
+#include <string_view>
+
+namespace csnap
+{
+
+void serialize(const IndexingResult& result, std::string& bytes);
+void deserialize(std::string_view bytes, IndexingResult& result);
+
+} // namespace csnap
+
+#endif // CSNAP_SERIALIZATION_H
@@ -0,0 +1,76 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#ifndef CSNAP_SNAPSHOTWRITER_H
+#define CSNAP_SNAPSHOTWRITER_H
+
+#include "queue.h"
+
+#include <csnap/database/pendingdata.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace csnap
+{
+
+class Snapshot;
+
+/**
+ * \brief writes the pending data of a snapshot on a dedicated thread
+ * 
+ * The pending data of the snapshot is handed over to the writer thread 
+ * by groups, either when enough rows have accumulated or when enough 
+ * time has passed since the last write (see update()).
+ * 
+ * While the writer is active, the snapshot's database connection is shared 
+ * between the writer thread and the thread using the snapshot; use sync() 
+ * before reading data that may not have been written yet.
+ */
+class SnapshotWriter
+{
+public:
+  explicit SnapshotWriter(Snapshot& s);
+  SnapshotWriter(const SnapshotWriter&) = delete;
+  ~SnapshotWriter();
+
+  Snapshot& snapshot() const;
+
+  void update();
+  void flush();
+  void sync();
+
+  SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+public:
+  /**
+   * \brief number of pending rows above which the data is written
+   */
+  size_t max_pending_rows = 100000;
+
+  /**
+   * \brief maximum amount of time between two writes
+   */
+  std::chrono::milliseconds max_delay{ 2000 };
+
+protected:
+  void run();
+
+private:
+  Snapshot& m_snapshot;
+  SharedQueue<std::unique_ptr<PendingData>> m_queue;
+  std::chrono::steady_clock::time_point m_last_flush;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  size_t m_nb_sent = 0;
+  size_t m_nb_written = 0;
+  std::thread m_thread;
+};
+
+} // namespace csnap
+
+#endif // CSNAP_SNAPSHOTWRITER_H
@@ -0,0 +1,145 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#ifndef CSNAP_WORKER_H
+#define CSNAP_WORKER_H
+
+#include <csnap/model/translationunit.h>
+
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace csnap
+{
+
+class Snapshot;
+
+/**
+ * \brief parses and indexes translation units on behalf of a WorkerPool
+ *
+ * A worker runs in a child process of the process that owns the snapshot
+ * (see the "csnap worker" command).
+ * It reads the ids of the translation units to process on its standard input
+ * and writes the serialized indexing results on its standard output.
+ *
+ * The snapshot passed to the constructor is only read; it must contain the
+ * files and translation units that will be sent to the worker.
+ */
+class Worker
+{
+public:
+  /**
+   * \brief whether the AST of the translation units should be saved
+   *
+   * The AST is saved in a temporary file whose path is sent along with
+   * the indexing result; the file must be removed by the receiver of the 
+   * result. If the worker fails before sending the result, the file is 
+   * removed by the WorkerPool.
+   */
+  bool save_ast = false;
+
+public:
+  explicit Worker(Snapshot& s);
+
+  void run();
+
+private:
+  Snapshot& m_snapshot;
+};
+
+/**
+ * \brief the outcome of the processing of a translation unit by a worker
+ */
+struct WorkerResult
+{
+  enum Status
+  {
+    Indexed,
+    ParsingFailed,
+    Crashed,
+    TimedOut,
+  };
+
+  TranslationUnit* source = nullptr;
+  Status status = Indexed;
+  std::chrono::milliseconds parsing_time{ 0 };
+
+  /**
+   * \brief the file in which the AST was saved, if any
+   */
+  std::filesystem::path ast_file;
+
+  /**
+   * \brief the indexing result, as produced by serialize()
+   */
+  std::string bytes;
+
+  /**
+   * \brief a description of the error if the worker crashed or timed out
+   */
+  std::string error;
+};
+
+/**
+ * \brief a pool of worker processes
+ *
+ * Each translation unit submitted to the pool is sent to one of the
+ * worker processes, which are started on demand.
+ * A worker that crashes, sends an invalid result, or exceeds the time 
+ * allowed for processing a translation unit, is terminated and replaced 
+ * by a new process; the translation unit is reported as failed and is 
+ * not retried.
+ *
+ * Workers communicate with the pool through pipes connected to their 
+ * standard input and output; on Windows, the output is a named pipe 
+ * so that it can be waited on with a timeout.
+ */
+class WorkerPool
+{
+public:
+  WorkerPool(std::vector<std::string> command, size_t n);
+  WorkerPool(const WorkerPool&) = delete;
+  ~WorkerPool();
+
+  std::chrono::milliseconds timeout() const;
+  void setTimeout(std::chrono::milliseconds timeout);
+
+  void submit(TranslationUnit* tu);
+  size_t pendingCount() const;
+
+  WorkerResult next();
+
+  size_t restartCount() const;
+
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+protected:
+  struct Process;
+
+  void start(Process& p);
+  int stop(Process& p, bool kill);
+  bool send(Process& p, TranslationUnit* tu);
+  void dispatch();
+  int waitTime() const;
+  bool consume(Process& p, const char* data, size_t size, WorkerResult& result);
+  bool checkDeadlines(WorkerResult& result);
+  bool receive(Process& p, WorkerResult& result);
+  WorkerResult fail(Process& p, WorkerResult::Status status, std::string error);
+
+private:
+  std::vector<std::string> m_command;
+  std::vector<std::unique_ptr<Process>> m_processes;
+  std::deque<TranslationUnit*> m_queue;
+  size_t m_nb_pending = 0;
+  size_t m_nb_restarts = 0;
+  std::chrono::milliseconds m_timeout{ 0 };
+};
+
+} // namespace csnap
+
+#endif // CSNAP_WORKER_H
@@ -4,7 +4,12 @@
 
 #include "aggregator.h"
 
+#include "snapshotwriter.h"
+
 #include "csnap/database/snapshot.h"
+#include "csnap/database/sqlqueries.h"
+
+#include "csnap/model/symbol.h"
 
 #include <algorithm>
 #include <iostream>
@@ -15,11 +20,32 @@ namespace csnap
 /**
  * \brief constructs a result aggregator on the snapshot
  * \param s  the snapshot
+ * 
+ * The aggregator is initialized with the symbols and references 
+ * already written in the snapshot's database.
  */
 IndexingResultAggregator::IndexingResultAggregator(Snapshot& s) :
   m_snapshot(s)
 {
+  // When updating an existing snapshot, we need to know what is already 
+  // in the database so that known symbols keep their id and so that 
+  // no duplicates are produced.
+  Database& db = s.database();
+
+  for (std::pair<SymbolId, std::string>& p : select_usr_from_symbol(db))
+  {
+    m_usrs.insert(p.second, p.first);
+  }
+
+  for (SymbolId id : select_distinct_symbol_id_from_base(db))
+  {
+    m_symbols_with_bases.insert(id);
+  }
 
+  for (const std::pair<const FileId, size_t>& p : select_count_from_symbolreference(db))
+  {
+    m_files_data[p.first].num_references = p.second;
+  }
 }
 
 /**
@@ -30,6 +56,82 @@ Snapshot& IndexingResultAggregator::snapshot() const
   return m_snapshot;
 }
 
+/**
+ * \brief sets the writer used to write the snapshot's data
+ * \param writer  the writer, may be nullptr
+ * 
+ * If a writer is set, the aggregator waits for all pending data to be written 
+ * before reading from the snapshot's database.
+ */
+void IndexingResultAggregator::setWriter(SnapshotWriter* writer)
+{
+  m_writer = writer;
+}
+
+/**
+ * \brief replaces the translation unit local symbol ids by global ids
+ * \param result  the indexing result of a translation unit
+ * 
+ * The indexer assigns ids to symbols that are only valid within a translation unit.
+ * This function resolves the USR of each symbol to a global id and rewrites the 
+ * ids of the symbols, references and base classes of \a result.
+ * Symbols (and base classes) that were already produced by another translation 
+ * unit are removed from \a result.
+ */
+void IndexingResultAggregator::remap(IndexingResult& result)
+{
+  // local ids are in the range [0, result.symbols.size())
+  std::vector<SymbolId> global_ids(result.symbols.size());
+  std::vector<std::shared_ptr<Symbol>> new_symbols;
+
+  for (const std::shared_ptr<Symbol>& sym : result.symbols)
+  {
+    auto [id, inserted] = m_usrs.get(sym->usr);
+    global_ids[sym->id.value()] = id;
+
+    if (inserted)
+      new_symbols.push_back(sym);
+  }
+
+  auto to_global = [&global_ids](SymbolId id) -> SymbolId {
+    return id.valid() ? global_ids[id.value()] : id;
+  };
+
+  for (const std::shared_ptr<Symbol>& sym : new_symbols)
+  {
+    sym->id = to_global(sym->id);
+    sym->parent_id = to_global(sym->parent_id);
+  }
+
+  result.symbols = std::move(new_symbols);
+
+  for (SymbolReference& ref : result.references)
+  {
+    ref.symbol_id = to_global(ref.symbol_id);
+    ref.parent_symbol_id = to_global(ref.parent_symbol_id);
+  }
+
+  std::map<SymbolId, std::vector<BaseClass>> bases;
+
+  for (std::pair<const SymbolId, std::vector<BaseClass>>& p : result.bases)
+  {
+    SymbolId id = to_global(p.first);
+
+    // the bases of a class are only listed once
+    if (!m_symbols_with_bases.insert(id).second)
+      continue;
+
+    for (BaseClass& b : p.second)
+    {
+      b.base_id = to_global(b.base_id);
+    }
+
+    bases[id] = std::move(p.second);
+  }
+
+  result.bases = std::move(bases);
+}
+
 /**
  * \brief removes all already references that are already known in the snapshot
  * \param references  a list of references
@@ -71,6 +173,11 @@ void IndexingResultAggregator::reduce(std::vector<SymbolReference>& references)
       {
         // Mismatch, we need to compare to see the difference.
         // (this branch should be unlikely to happen)
+        if (m_writer)
+          m_writer->sync();
+        else
+          snapshot().writePendingData();
+
         std::vector<SymbolReference> refsinfile = snapshot().listReferencesInFile(current_file_id);
 
         auto already_exists = [&refsinfile](const SymbolReference& r) {
@@ -9,11 +9,11 @@
 #include "csnap/model/file.h"
 #include "csnap/model/reference.h"
 #include "csnap/model/symbol.h"
-#include "csnap/model/usrmap.h"
 
 #include <libclang-utils/index-action.h>
 #include <libclang-utils/clang-cursor.h>
 
+#include <algorithm>
 #include <cassert>
 #include <filesystem>
 #include <iostream>
@@ -25,16 +25,15 @@ class TranslationUnitIndexer : public libclang::BasicIndexer
 {
 private:
   csnap::Indexer& indexer;
-  UsrMap usrs;
   std::map<std::string, std::shared_ptr<Symbol>> symbols;
+  int local_id_generator = 0; // see new_symbol_id()
 
 public:
   IndexingResult result;
 
 public:
-  TranslationUnitIndexer(csnap::Indexer& idx, TranslationUnit* tu) : libclang::BasicIndexer(idx.libclangAPI()),
-    indexer(idx),
-    usrs(idx.sharedUsrMap().clone())
+  TranslationUnitIndexer(csnap::Indexer& idx, libclang::IndexAction& action, TranslationUnit* tu) : libclang::BasicIndexer(action.api),
+    indexer(idx)
   {
     result.source = tu;
   }
@@ -75,7 +74,7 @@ public:
     // indexDeclaration() or indexEntityReference() so this function cannot be used 
     // to know in which file "we currently are". 
 
-    std::string path = indexer.libclangAPI().file(inclFile->file).getFileName();
+    std::string path = libclangAPI().file(inclFile->file).getFileName();
 
     auto [rawptr, owningptr] = indexer.getFile(path);
 
@@ -192,13 +191,19 @@ protected:
     return it != symbols.end() ? it->second.get() : nullptr;
   }
 
-  Symbol* insert_placeholder_symbol(SymbolId id, std::string usr)
+  SymbolId new_symbol_id()
   {
-    auto symbol = std::make_shared<Symbol>();
-    symbol->id = id;
-    symbols[usr] = symbol;
-    symbol->usr = std::move(usr);
-    return symbol.get();
+    // Symbol ids are local to the translation unit and are later 
+    // replaced by global ids (see IndexingResultAggregator::remap()).
+    // This way, indexing does not require any synchronization between 
+    // the indexing threads.
+    return SymbolId(local_id_generator++);
+  }
+
+  void insert_symbol(const std::string& usr, std::shared_ptr<Symbol> sym)
+  {
+    result.symbols.push_back(sym);
+    symbols[usr] = std::move(sym);
   }
 
   Symbol* get_symbol(const CXIdxDeclInfo* decl)
@@ -222,27 +227,10 @@ protected:
       return symbol;
     }
 
-    SymbolId id = usrs.find(usr);
-
-    if (id.valid())
-    {
-      return insert_placeholder_symbol(id, std::move(usr));
-    }
-
-    // $TODO: maybe we should assign temporary ids to 
-    // the symbols and then rewrite the id when aggregating 
-    // the indexing results.
-    auto [uid, inserted] = indexer.sharedUsrMap().get(usr);
-    id = uid;
-    // update local "cache"
-    usrs.insert(usr, id);
+    // First time we encounter the symbol in this translation unit, we need 
+    // to create and fill the corresponding Symbol struct.
 
-    if (!inserted)
-      return insert_placeholder_symbol(id, std::move(usr));
-
-    // The SymbolId was just created, we need to create and fill the corresponding Symbol struct.
-
-    std::shared_ptr<Symbol> sym = create_symbol(decl, id);
+    std::shared_ptr<Symbol> sym = create_symbol(decl, new_symbol_id());
 
     if (sym->kind == Whatsit::CXXClass)
     {
@@ -251,8 +239,7 @@ protected:
 
     fill_symbol(*sym, libclangAPI().cursor(decl->cursor));
 
-    symbols[usr] = sym;
-    result.symbols.push_back(sym);
+    insert_symbol(usr, sym);
 
     return sym.get();
   }
@@ -267,25 +254,9 @@ protected:
     if (Symbol* symbol = lookup_symbol(usr))
       return symbol;
 
-    SymbolId id = usrs.find(usr);
-
-    if (id.valid())
-      return insert_placeholder_symbol(id, std::move(usr));
-
-    auto [uid, inserted] = indexer.sharedUsrMap().get(usr);
-    id = uid;
-    // update local "cache"
-    usrs.insert(usr, id);
-
-    if (!inserted)
-      return insert_placeholder_symbol(id, std::move(usr));
-
-    // The SymbolId was just created, we need to create and fill the corresponding Symbol struct.
-
-    std::shared_ptr<Symbol> sym = create_symbol(info, id);
+    std::shared_ptr<Symbol> sym = create_symbol(info, new_symbol_id());
 
-    symbols[usr] = sym;
-    result.symbols.push_back(sym);
+    insert_symbol(usr, sym);
 
     return sym.get();
   }
@@ -324,25 +295,14 @@ private:
     if (usr.empty())
       return SymbolId();
 
-    SymbolId id = usrs.find(usr);
-
-    if (id.valid())
-      return id;
-
-    auto [uid, inserted] = indexer.sharedUsrMap().get(usr);
-    id = uid;
-    // update local "cache"
-    usrs.insert(usr, id);
-
-    if (!inserted)
-      return id;
+    if (Symbol* symbol = lookup_symbol(usr))
+      return symbol->id;
 
     // create symbol
-    std::shared_ptr<Symbol> sym = create_symbol(cursor, id, static_cast<Whatsit>(it->second));
-    symbols[usr] = sym;
-    result.symbols.push_back(sym);
+    std::shared_ptr<Symbol> sym = create_symbol(cursor, new_symbol_id(), static_cast<Whatsit>(it->second));
+    insert_symbol(usr, sym);
 
-    return id;
+    return sym->id;
   }
 
   SymbolId get_parent_symbol_id(const CXIdxEntityInfo* info)
@@ -480,28 +440,37 @@ public:
     indexer(idxr),
     parsingResult(std::move(pr))
   {
-    m_task_number = ++m_task_counter;
+    // The task is constructed on the thread that feeds the indexer, we can 
+    // safely access the snapshot here (but not in run()).
+    const File* sourcefile = indexer.snapshot().files().get(parsingResult.source->sourcefile_id);
+    m_header = "[" + std::to_string(++m_task_counter) + "/" + std::to_string(indexer.snapshot().translationUnits().count()) + "] " + sourcefile->path;
   }
 
   void run() override
   {
-    const File* sourcefile = indexer.snapshot().files().get(parsingResult.source->sourcefile_id);
-    std::cout << "[" << m_task_number << "/" << indexer.snapshot().translationUnits().count() << "] " << sourcefile->path << std::endl;
+    std::cout << (m_header + "\n") << std::flush;
+
+    std::unique_ptr<libclang::IndexAction> action = indexer.takeIndexAction();
 
     auto start = std::chrono::high_resolution_clock::now();
 
-    TranslationUnitIndexer tui{ indexer, parsingResult.source };
-    indexer.indexAction().indexTranslationUnit(*parsingResult.result, tui);
+    TranslationUnitIndexer tui{ indexer, *action, parsingResult.source };
+    action->indexTranslationUnit(*parsingResult.result, tui);
 
     auto end = std::chrono::high_resolution_clock::now();
     tui.result.indexing_time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
 
+    indexer.releaseIndexAction(std::move(action));
+
+    // the AST is no longer needed, release it before handing over the results
+    parsingResult.result.reset();
+
     indexer.results().write(std::move(tui.result));
   }
 
 private:
   static size_t m_task_counter;
-  size_t m_task_number;
+  std::string m_header;
 };
 
 size_t IndexTranslationUnit::m_task_counter = 0;
@@ -509,10 +478,18 @@ size_t IndexTranslationUnit::m_task_counter = 0;
 Indexer::Indexer(libclang::Index& index, Snapshot& snapshot) :
   m_index(index),
   m_snapshot(snapshot),
-  m_threads(1), // $Note: not sure clang index action is thread-safe so we only use 1 thread for indexing
-  m_file_id_generator((int)snapshot.files().all().size())
+  m_threads(1)
 {
-  m_index_action = std::make_unique<libclang::IndexAction>(index);
+  for (File* f : snapshot.files().all())
+  {
+    m_known_files.emplace(std::string_view(f->path), f);
+    m_file_ids.insert(f->id.value());
+  }
+
+  auto action = std::make_unique<libclang::IndexAction>(index);
+  m_libclang = &action->api;
+  m_index_actions.write(std::move(action));
+  m_nb_index_actions = 1;
 }
 
 Indexer::~Indexer()
@@ -525,12 +502,7 @@ Indexer::~Indexer()
 
 libclang::LibClang& Indexer::libclangAPI()
 {
-  return indexAction().api;
-}
-
-libclang::IndexAction& Indexer::indexAction()
-{
-  return *m_index_action;
+  return *m_libclang;
 }
 
 /**
@@ -541,14 +513,42 @@ Snapshot& Indexer::snapshot() const
   return m_snapshot;
 }
 
+/**
+ * \brief returns the number of threads used for indexing
+ */
+size_t Indexer::threadCount() const
+{
+  return m_threads.threadCount();
+}
+
+/**
+ * \brief sets the number of threads used for indexing
+ * \param n  the number of threads
+ * 
+ * Each thread uses its own libclang index action so that translation units 
+ * can be indexed in parallel.
+ * This function should not be called while indexing tasks are running.
+ */
+void Indexer::setThreadCount(size_t n)
+{
+  n = std::clamp(n, size_t(1), std::max(size_t(1), (size_t)std::thread::hardware_concurrency()));
+
+  while (m_nb_index_actions < n)
+  {
+    m_index_actions.write(std::make_unique<libclang::IndexAction>(m_index));
+    ++m_nb_index_actions;
+  }
+
+  m_threads.setThreadCount(n);
+}
+
 /**
  * \brief starts the indexing of a translation unit asynchronously
  * \param parsingResult  parsing result as produced by the Parser class
  * 
- * Please note that although indexing is performed asynchronously, it is 
- * not really "multi-threaded": only a sinlge thread performs the indexing.
- * This means that the indexing of @a parsingResult will only start after 
- * all previous calls to asyncIndex() have completed.
+ * The translation unit is indexed by one of the indexing threads 
+ * (see setThreadCount()); results are written in the results() queue 
+ * in the order in which the tasks complete.
  */
 void Indexer::asyncIndex(TranslationUnitParsingResult parsingResult)
 {
@@ -587,29 +587,70 @@ IndexerResultQueue& Indexer::results()
  */
 std::pair<File*, std::unique_ptr<File>> Indexer::getFile(std::string path)
 {
-  // $TODO: make thread-safe
+  // We do not use the snapshot here as it may be modified concurrently by 
+  // the thread consuming the results.
+  // Files that were in the snapshot when the indexer was created are in an 
+  // index that is never modified and can therefore be read without locking;
+  // files discovered while indexing are stored in a separate map.
 
-  File* f = snapshot().findFile(path);
+  path = Snapshot::getCanonicalPath(std::move(path));
 
-  if (f || !collect_new_files)
-    return { f, nullptr };
+  auto known = m_known_files.find(path);
 
-  f = new File;
+  if (known != m_known_files.end())
+    return { known->second, nullptr };
+
+  if (!collect_new_files)
+    return { nullptr, nullptr };
+
+  {
+    std::shared_lock lock{ m_new_files_mutex };
+    auto it = m_new_files.find(path);
+
+    if (it != m_new_files.end())
+      return { it->second, nullptr };
+  }
+
+  std::unique_lock lock{ m_new_files_mutex };
+
+  // another thread may have created the file in the meantime
+  auto [it, inserted] = m_new_files.try_emplace(path, nullptr);
+
+  if (!inserted)
+    return { it->second, nullptr };
+
+  auto f = std::make_unique<File>();
   f->path = std::move(path);
-  f->id = FileId(m_file_id_generator++);
+  // the id is reserved by the lambda as soon as it is found to be unused
+  f->id = FileList::newId(f->path, [this](FileId id) {
+    return !m_file_ids.insert(id.value()).second;
+    });
+
+  // the File object is owned by the IndexingResult and then by the snapshot, 
+  // so the pointer remains valid
+  it->second = f.get();
 
-  return { nullptr, std::unique_ptr<File>(f) };
+  return { nullptr, std::move(f) };
 }
 
 /**
- * \brief a usr map shared among all indexing tasks
+ * \brief takes an index action from the pool
  * 
- * USRs (Unified Symbol Resolution) are used to match symbols across translation units.
- * This map is used to always assign the same id to a symbol across all indexing tasks.
+ * Index actions must not be shared between threads, this function 
+ * is used by the indexing tasks to get exclusive access to an action.
+ * The action must be given back with releaseIndexAction().
+ */
+std::unique_ptr<libclang::IndexAction> Indexer::takeIndexAction()
+{
+  return m_index_actions.next();
+}
+
+/**
+ * \brief puts back an index action in the pool
  */
-GlobalUsrMap& Indexer::sharedUsrMap()
+void Indexer::releaseIndexAction(std::unique_ptr<libclang::IndexAction> action)
 {
-  return m_usrs;
+  m_index_actions.write(std::move(action));
 }
 
 } // namespace csnap
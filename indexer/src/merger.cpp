@@ -0,0 +1,289 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#include "merger.h"
+
+#include "csnap/database/snapshot.h"
+#include "csnap/database/sqlqueries.h"
+#include "csnap/database/symbolloader.h"
+#include "csnap/database/transaction.h"
+
+#include "csnap/model/symbol.h"
+#include "csnap/model/version.h"
+
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace csnap
+{
+
+// number of pending rows above which the data is written to the database
+static constexpr size_t MergeWriteThreshold = 16 * 1024;
+
+/**
+ * \brief constructs a merger writing into a snapshot
+ * \param output  the snapshot that receives the merged data
+ *
+ * \a output is usually empty, but may already contain data, in which
+ * case the merged data is deduplicated against it.
+ */
+SnapshotMerger::SnapshotMerger(Snapshot& output) :
+  m_output(output),
+  m_aggregator(output)
+{
+  Database& db = output.database();
+
+  for (std::pair<SymbolId, std::string>& p : select_usr_from_symbol(db))
+  {
+    m_usrs.insert(p.second, p.first);
+  }
+
+  for (SymbolId id : select_distinct_symbol_id_from_base(db))
+  {
+    m_symbols_with_bases.insert(id);
+  }
+
+  for (const std::pair<const TranslationUnitId, std::set<FileId>>& p : select_included_file_id_from_ppinclude(db))
+  {
+    m_units_with_includes.insert(p.first);
+  }
+
+  m_output.setProperty("csnap.version", csnap::versionstring());
+}
+
+/**
+ * \brief returns the snapshot that receives the merged data
+ */
+Snapshot& SnapshotMerger::output() const
+{
+  return m_output;
+}
+
+/**
+ * \brief merges a snapshot into the output snapshot
+ * \param input  the snapshot to merge
+ *
+ * All the data of \a input is written to the output database before
+ * this function returns.
+ */
+void SnapshotMerger::merge(Snapshot& input)
+{
+  Database& indb = input.database();
+  Database& outdb = m_output.database();
+
+  std::string sln = input.property("sln.path");
+  std::string outsln = m_output.property("sln.path");
+
+  if (outsln.empty())
+    m_output.setProperty("sln.path", sln);
+  else if (!sln.empty() && sln != outsln)
+    std::cerr << "warning: merging snapshots of different solutions: " << sln << std::endl;
+
+  // files are matched by path
+
+  std::unordered_map<int64_t, FileId> files;
+
+  for (File* f : input.files().all())
+  {
+    File* outfile = m_output.findFile(f->path);
+
+    if (!outfile)
+      outfile = m_output.addFile(create_file(f->path));
+
+    files[f->id.value()] = outfile->id;
+  }
+
+  auto to_output_file = [&files](FileId id) -> FileId {
+    auto it = files.find(id.value());
+    return it != files.end() ? it->second : FileId();
+  };
+
+  // the content of the files is copied unless the output already has it
+
+  m_output.writePendingData();
+
+  {
+    std::map<FileId, std::string> hashes = select_hash_from_file(indb);
+    std::map<FileId, std::string> outhashes = select_hash_from_file(outdb);
+
+    sql::Transaction transaction{ outdb };
+
+    for (const std::pair<const FileId, std::string>& p : hashes)
+    {
+      FileId outid = to_output_file(p.first);
+
+      if (!outid.valid() || outhashes.find(outid) != outhashes.end())
+        continue;
+
+      insert_file_content(outdb, outid, select_content_from_file(indb, p.first), p.second);
+    }
+  }
+
+  // symbols are matched by USR
+
+  std::unordered_map<int64_t, SymbolId> symbols;
+  std::unordered_set<int64_t> new_symbols;
+
+  for (std::pair<SymbolId, std::string>& p : select_usr_from_symbol(indb))
+  {
+    auto [id, inserted] = m_usrs.get(p.second);
+    symbols[p.first.value()] = id;
+
+    if (inserted)
+      new_symbols.insert(p.first.value());
+  }
+
+  auto to_output_symbol = [&symbols](SymbolId id) -> SymbolId {
+    if (!id.valid())
+      return id;
+
+    auto it = symbols.find(id.value());
+    return it != symbols.end() ? it->second : SymbolId();
+  };
+
+  {
+    std::vector<std::shared_ptr<Symbol>> batch;
+    SymbolEnumerator enumerator{ input };
+
+    while (enumerator.next())
+    {
+      if (new_symbols.find(enumerator.symbol.id.value()) == new_symbols.end())
+        continue;
+
+      auto sym = std::make_shared<Symbol>(enumerator.symbol);
+      sym->id = to_output_symbol(sym->id);
+      sym->parent_id = to_output_symbol(sym->parent_id);
+      batch.push_back(sym);
+
+      if (batch.size() == SymbolBatchLoader::BatchSize)
+      {
+        m_output.addSymbols(batch);
+        batch.clear();
+        writeIfNeeded();
+      }
+    }
+
+    m_output.addSymbols(batch);
+  }
+
+  // the bases of a class are only listed once
+
+  for (SymbolId id : select_distinct_symbol_id_from_base(indb))
+  {
+    SymbolId outid = to_output_symbol(id);
+
+    if (!m_symbols_with_bases.insert(outid).second)
+      continue;
+
+    std::vector<BaseClass> bases = select_from_base(indb, id);
+
+    for (BaseClass& b : bases)
+    {
+      b.base_id = to_output_symbol(b.base_id);
+    }
+
+    m_output.addBases(outid, bases);
+  }
+
+  writeIfNeeded();
+
+  // includes; duplicates are ignored by the database
+
+  auto remap_includes = [&to_output_file](std::vector<Include>& includes) {
+    for (Include& inc : includes)
+    {
+      inc.file_id = to_output_file(inc.file_id);
+      inc.included_file_id = to_output_file(inc.included_file_id);
+    }
+  };
+
+  {
+    std::vector<Include> includes = select_from_include(indb);
+    remap_includes(includes);
+    m_output.addIncludes(includes);
+  }
+
+  // translation units are matched by source file
+
+  {
+    std::map<const program::CompileOptions*, std::vector<FileId>> new_units;
+
+    for (TranslationUnit* tu : input.translationUnits().all())
+    {
+      FileId src = to_output_file(tu->sourcefile_id);
+
+      if (!m_output.translationUnits().find(src))
+        new_units[tu->compile_options.get()].push_back(src);
+    }
+
+    for (const std::pair<const program::CompileOptions* const, std::vector<FileId>>& p : new_units)
+    {
+      m_output.addTranslationUnits(p.second, p.first ? *p.first : program::CompileOptions());
+    }
+
+    // timings are only known by the snapshot in which the translation unit was indexed
+    for (TranslationUnit* tu : input.translationUnits().all())
+    {
+      TranslationUnit* outtu = m_output.translationUnits().find(to_output_file(tu->sourcefile_id));
+
+      if (tu->parsing_time.count() >= 0 && outtu->parsing_time.count() < 0)
+        m_output.setTranslationUnitTimings(outtu, tu->parsing_time, tu->indexing_time);
+    }
+  }
+
+  // a translation unit is only indexed in one shard, only that shard
+  // has the #include directives processed by the translation unit
+
+  for (std::pair<const TranslationUnitId, std::vector<Include>>& p : select_from_ppinclude(indb))
+  {
+    TranslationUnit* tu = input.getTranslationUnit(p.first);
+
+    if (!tu)
+      continue;
+
+    TranslationUnit* outtu = m_output.translationUnits().find(to_output_file(tu->sourcefile_id));
+
+    if (!outtu || !m_units_with_includes.insert(outtu->id).second)
+      continue;
+
+    remap_includes(p.second);
+    m_output.addIncludes(p.second, outtu);
+  }
+
+  writeIfNeeded();
+
+  // references are merged file by file
+
+  for (const std::pair<const FileId, size_t>& p : select_count_from_symbolreference(indb))
+  {
+    std::vector<SymbolReference> refs = select_symbolreference(indb, p.first);
+
+    for (SymbolReference& ref : refs)
+    {
+      ref.symbol_id = to_output_symbol(ref.symbol_id);
+      ref.file_id = to_output_file(ref.file_id);
+      ref.parent_symbol_id = to_output_symbol(ref.parent_symbol_id);
+    }
+
+    m_aggregator.reduce(refs);
+    m_output.addSymbolReferences(refs);
+
+    writeIfNeeded();
+  }
+
+  m_output.writePendingData();
+}
+
+/**
+ * \brief writes the pending data of the output snapshot if enough rows have accumulated
+ */
+void SnapshotMerger::writeIfNeeded()
+{
+  if (m_output.pendingRowCount() >= MergeWriteThreshold)
+    m_output.writePendingData();
+}
+
+} // namespace csnap
@@ -78,6 +78,9 @@ Parser::~Parser()
   {
     std::cout << "Warning: results() isn't empty in ~Parser()" << std::endl;
   }
+
+  // unblock the threads that may be waiting for the queue to have room
+  results().setCapacity(0);
 }
 
 /**
@@ -7,10 +7,21 @@
 #include "aggregator.h"
 #include "indexer.h"
 #include "parser.h"
+#include "serialization.h"
 #include "sln.h"
+#include "snapshotwriter.h"
+#include "worker.h"
 
+#include "csnap/model/file.h"
+#include "csnap/model/hash.h"
 #include "csnap/model/version.h"
 
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+
 namespace csnap
 {
 
@@ -25,8 +36,9 @@ void save_to_db(TranslationUnitParsingResult& parsingResult, Snapshot& snapshot)
   std::filesystem::remove(path);
 }
 
-void process_indexing_result(IndexingResult& idxres, IndexingResultAggregator& aggregator)
+void process_indexing_result(IndexingResult& idxres, std::chrono::milliseconds parsing_time, IndexingResultAggregator& aggregator, SnapshotWriter& writer)
 {
+  aggregator.remap(idxres);
   aggregator.reduce(idxres.references);
 
   Snapshot& snapshot = aggregator.snapshot();
@@ -49,7 +61,9 @@ void process_indexing_result(IndexingResult& idxres, IndexingResultAggregator& a
 
   snapshot.addSymbolReferences(idxres.references);
 
-  snapshot.writePendingData();
+  snapshot.setTranslationUnitTimings(idxres.source, parsing_time, idxres.indexing_time);
+
+  writer.update();
 }
 
 /**
@@ -63,38 +77,131 @@ void Scanner::initSnapshot(std::filesystem::path& p)
   m_snapshot->setProperty("csnap.version", csnap::versionstring());
 }
 
+/**
+ * \brief opens an existing snapshot for an update
+ * \param p  the path of the database
+ * 
+ * When scanning, only the translation units that depend on a file that 
+ * was modified since the last scan are indexed again.
+ */
+void Scanner::openSnapshot(const std::filesystem::path& p)
+{
+  m_snapshot = std::make_unique<Snapshot>(Snapshot::open(p));
+  m_snapshot->upgrade();
+  m_update = true;
+
+  m_snapshot->setProperty("csnap.version", csnap::versionstring());
+}
+
+/**
+ * \brief returns the snapshot
+ * 
+ * \warning initSnapshot() or openSnapshot() must have been called.
+ */
+Snapshot& Scanner::snapshot() const
+{
+  return *m_snapshot;
+}
+
 /**
  * \brief fills the snapshot by scanning a Visual Studio solution
  * \param slnPath  path to the sln file
  * 
- * \warning initSnapshot() must be called before calling this function.
+ * \warning initSnapshot() or openSnapshot() must be called before calling this function.
  */
 void Scanner::scanSln(const std::filesystem::path& slnPath)
 {
+  m_snapshot->beginBulkLoad();
+
   openSln(slnPath, *m_snapshot);
 
   m_snapshot->writePendingData();
 
+  std::vector<TranslationUnit*> units = m_update ? prepareUpdate() : m_snapshot->translationUnits().all();
+
+  if (this->shard_count > 1)
+  {
+    units.erase(std::remove_if(units.begin(), units.end(), [this](TranslationUnit* tu) {
+      return !isInShard(*tu);
+      }), units.end());
+
+    std::cout << "shard " << this->shard_index << "/" << this->shard_count << ": " 
+      << units.size() << " translation unit(s) to index" << std::endl;
+  }
+
+  sortLongestFirst(units);
+
+  if (this->nb_workers > 0)
+    indexWithWorkers(units);
+  else
+    indexInProcess(units);
+
+  // build the indexes in one pass now that all rows are inserted
+  m_snapshot->createIndexes();
+
+  m_snapshot->endBulkLoad();
+}
+
+/**
+ * \brief parses and indexes translation units in the current process
+ * \param units  the translation units
+ */
+void Scanner::indexInProcess(const std::vector<TranslationUnit*>& units)
+{
   libclang::LibClang clang;
   libclang::Index index = clang.createIndex();
 
   Parser parser{ index, m_snapshot->files() };
   parser.setThreadCount(this->nb_parsing_threads);
+  // Parsing results hold a complete AST in memory, we limit the number 
+  // of results waiting to be indexed.
+  parser.results().setCapacity(std::max(this->parsing_queue_depth, 0));
 
-  for (TranslationUnit* tu : m_snapshot->translationUnits().all())
+  for (TranslationUnit* tu : units)
   {
     parser.asyncParse(tu);
   }
 
-  // We have some time before parsing results become available, 
-  // we use this time to save the file's content into database:
-  m_snapshot->addFilesContent();
+  if (!m_update)
+  {
+    // We have some time before parsing results become available, 
+    // we use this time to save the file's content into database:
+    m_snapshot->addFilesContent();
+  }
 
   Indexer indexer{ index, *m_snapshot };
+  indexer.setThreadCount(this->nb_indexing_threads);
   IndexingResultAggregator aggregator{ *m_snapshot };
 
-  while (!parser.done() || !parser.results().empty())
+  // From now on, the data is written to the database by a dedicated thread.
+  SnapshotWriter writer{ *m_snapshot };
+  aggregator.setWriter(&writer);
+
+  // number of translation units sent to the indexer whose result 
+  // has not been processed yet
+  size_t nb_indexing = 0;
+
+  // parsing time of the translation units being indexed
+  std::map<TranslationUnit*, std::chrono::milliseconds> parsing_times;
+
+  auto process_next_result = [&]() {
+    IndexingResult idxres{ indexer.results().next() };
+    auto it = parsing_times.find(idxres.source);
+    process_indexing_result(idxres, it->second, aggregator, writer);
+    parsing_times.erase(it);
+    --nb_indexing;
+  };
+
+  // every call to asyncParse() produces exactly one result
+  for (size_t i(0); i < units.size(); ++i)
   {
+    // Do not take more parsing results than the indexer can process, 
+    // so that the parser blocks when its result queue is full.
+    while (nb_indexing >= indexer.threadCount())
+    {
+      process_next_result();
+    }
+
     TranslationUnitParsingResult pr{ parser.results().next() };
 
     if (pr.result)
@@ -104,21 +211,266 @@ void Scanner::scanSln(const std::filesystem::path& slnPath)
         save_to_db(pr, *m_snapshot);
       }
 
+      parsing_times[pr.source] = pr.parsing_time;
       indexer.asyncIndex(std::move(pr));
+      ++nb_indexing;
+    }
+    else
+    {
+      m_snapshot->setTranslationUnitTimings(pr.source, pr.parsing_time, std::chrono::milliseconds(0));
     }
 
     while (!indexer.results().empty())
     {
-      IndexingResult idxres{ indexer.results().next() };
-      process_indexing_result(idxres, aggregator);
+      process_next_result();
     }
   }
 
-  while (!indexer.done() || !indexer.results().empty())
+  while (nb_indexing > 0)
   {
-    IndexingResult idxres{ indexer.results().next() };
-    process_indexing_result(idxres, aggregator);
+    process_next_result();
+  }
+
+  writer.sync();
+}
+
+/**
+ * \brief parses and indexes translation units in worker processes
+ * \param units  the translation units
+ * 
+ * Each worker runs the "worker" command of the worker_program and 
+ * processes one translation unit at a time; a worker that crashes or 
+ * exceeds worker_timeout is replaced and its translation unit is skipped.
+ */
+void Scanner::indexWithWorkers(const std::vector<TranslationUnit*>& units)
+{
+  Database& db = m_snapshot->database();
+
+  // the workers read the snapshot while this process writes into it
+  db.setBusyTimeout(std::chrono::minutes(1));
+
+  std::vector<std::string> command{ this->worker_program.u8string(), "worker", "--snapshot", db.path().u8string() };
+
+  if (save_ast)
+    command.push_back("--save-ast");
+
+  WorkerPool pool{ std::move(command), size_t(std::max(this->nb_workers, 1)) };
+  pool.setTimeout(std::chrono::seconds(std::max(this->worker_timeout, 0)));
+
+  for (TranslationUnit* tu : units)
+  {
+    pool.submit(tu);
+  }
+
+  if (!m_update)
+  {
+    // see indexInProcess()
+    m_snapshot->addFilesContent();
+  }
+
+  IndexingResultAggregator aggregator{ *m_snapshot };
+  SnapshotWriter writer{ *m_snapshot };
+  aggregator.setWriter(&writer);
+
+  size_t nb_failures = 0;
+
+  while (pool.pendingCount() > 0)
+  {
+    WorkerResult wr = pool.next();
+    const std::string& path = m_snapshot->getFile(wr.source->sourcefile_id)->path;
+
+    if (wr.status != WorkerResult::Indexed)
+    {
+      if (wr.status == WorkerResult::ParsingFailed)
+      {
+        std::cerr << "could not parse " << path << std::endl;
+        m_snapshot->setTranslationUnitTimings(wr.source, wr.parsing_time, std::chrono::milliseconds(0));
+      }
+      else
+      {
+        std::cerr << "could not index " << path << ": " << wr.error << std::endl;
+      }
+
+      ++nb_failures;
+      continue;
+    }
+
+    IndexingResult idxres;
+    idxres.source = wr.source;
+
+    try
+    {
+      deserialize(wr.bytes, idxres);
+    }
+    catch (const std::runtime_error& e)
+    {
+      std::cerr << "could not index " << path << ": " << e.what() << std::endl;
+
+      std::error_code ec;
+      std::filesystem::remove(wr.ast_file, ec);
+
+      ++nb_failures;
+      continue;
+    }
+
+    if (!wr.ast_file.empty())
+    {
+      m_snapshot->addTranslationUnitSerializedAst(wr.source, wr.ast_file);
+      std::filesystem::remove(wr.ast_file);
+    }
+
+    process_indexing_result(idxres, wr.parsing_time, aggregator, writer);
+  }
+
+  writer.sync();
+
+  if (nb_failures > 0 || pool.restartCount() > 0)
+  {
+    std::cout << nb_failures << " translation unit(s) could not be indexed, " 
+      << pool.restartCount() << " worker(s) restarted" << std::endl;
   }
 }
 
+/**
+ * \brief prepares the update of the snapshot
+ * \return the list of translation units that need to be indexed again
+ * 
+ * A translation unit needs to be indexed again if its source file or any of 
+ * the files it includes was modified.
+ * The previous indexing results of these translation units, and of the 
+ * modified files, are removed from the snapshot; the content of the 
+ * modified files is saved again.
+ */
+std::vector<TranslationUnit*> Scanner::prepareUpdate()
+{
+  std::vector<File*> modified_files = m_snapshot->listModifiedFiles();
+
+  std::set<FileId> modified;
+
+  for (File* f : modified_files)
+    modified.insert(f->id);
+
+  std::map<TranslationUnitId, std::set<FileId>> dependencies = m_snapshot->listTranslationUnitDependencies();
+
+  auto is_outdated = [&modified, &dependencies](const TranslationUnit& tu) -> bool {
+    if (modified.find(tu.sourcefile_id) != modified.end())
+      return true;
+
+    auto it = dependencies.find(tu.id);
+
+    if (it == dependencies.end())
+      return false;
+
+    return std::any_of(it->second.begin(), it->second.end(), [&modified](FileId f) {
+      return modified.find(f) != modified.end();
+      });
+  };
+
+  std::vector<TranslationUnit*> units;
+  std::set<FileId> files = modified;
+
+  for (TranslationUnit* tu : m_snapshot->translationUnits().all())
+  {
+    if (!is_outdated(*tu))
+      continue;
+
+    units.push_back(tu);
+    files.insert(tu->sourcefile_id);
+  }
+
+  std::cout << modified_files.size() << " modified file(s), " 
+    << units.size() << " translation unit(s) to index" << std::endl;
+
+  m_snapshot->removeIndexingResults(units, files);
+  m_snapshot->addFilesContent(modified_files);
+
+  // translation units whose source file was deleted cannot be parsed
+  units.erase(std::remove_if(units.begin(), units.end(), [this](TranslationUnit* tu) {
+    return !std::filesystem::exists(m_snapshot->getFile(tu->sourcefile_id)->path);
+    }), units.end());
+
+  return units;
+}
+
+/**
+ * \brief sorts translation units by decreasing estimated processing time
+ * \param units  the translation units
+ * 
+ * Starting with the longest translation units avoids ending a scan with 
+ * a single thread (or worker) processing a long translation unit while 
+ * the others are idle.
+ * 
+ * The processing time of a translation unit is the time it took to parse 
+ * and index it during the previous scan. 
+ * For translation units that were never scanned, the time is estimated 
+ * from the size of the source file, using the average time per byte of 
+ * the translation units that were scanned.
+ */
+void Scanner::sortLongestFirst(std::vector<TranslationUnit*>& units) const
+{
+  auto has_timings = [](const TranslationUnit& tu) {
+    return tu.parsing_time.count() >= 0 && tu.indexing_time.count() >= 0;
+  };
+
+  auto file_size = [this](const TranslationUnit& tu) -> uintmax_t {
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(m_snapshot->getFile(tu.sourcefile_id)->path, ec);
+    return ec ? 0 : size;
+  };
+
+  std::vector<uintmax_t> sizes;
+  sizes.reserve(units.size());
+  double total_time = 0;
+  double total_size = 0;
+
+  for (TranslationUnit* tu : units)
+  {
+    sizes.push_back(file_size(*tu));
+
+    if (has_timings(*tu))
+    {
+      total_time += double((tu->parsing_time + tu->indexing_time).count());
+      total_size += double(sizes.back());
+    }
+  }
+
+  const double ms_per_byte = (total_time > 0 && total_size > 0) ? total_time / total_size : 1.0;
+
+  std::vector<std::pair<double, TranslationUnit*>> costs;
+  costs.reserve(units.size());
+
+  for (size_t i(0); i < units.size(); ++i)
+  {
+    const TranslationUnit& tu = *units[i];
+    double cost = has_timings(tu) ? double((tu.parsing_time + tu.indexing_time).count()) : double(sizes[i]) * ms_per_byte;
+    costs.emplace_back(cost, units[i]);
+  }
+
+  std::stable_sort(costs.begin(), costs.end(), [](const std::pair<double, TranslationUnit*>& a, const std::pair<double, TranslationUnit*>& b) {
+    return a.first > b.first;
+    });
+
+  for (size_t i(0); i < units.size(); ++i)
+  {
+    units[i] = costs[i].second;
+  }
+}
+
+/**
+ * \brief returns whether a translation unit belongs to the shard being scanned
+ * \param tu  the translation unit
+ * 
+ * The shard is derived from a hash of the path of the source file so that 
+ * every scan of the same solution splits the translation units the same way.
+ */
+bool Scanner::isInShard(const TranslationUnit& tu) const
+{
+  if (this->shard_count <= 1)
+    return true;
+
+  File* file = m_snapshot->getFile(tu.sourcefile_id);
+  uint64_t h = static_cast<uint64_t>(stable_id(file->path));
+  return h % static_cast<uint64_t>(this->shard_count) == static_cast<uint64_t>(this->shard_index);
+}
+
 } // namespace csnap
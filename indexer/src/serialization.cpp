@@ -0,0 +1,224 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#include "serialization.h"
+
+#include "csnap/model/symbol.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace csnap
+{
+
+namespace
+{
+
+// Values are written in the byte order of the machine: the bytes are only 
+// exchanged between processes running the same executable.
+
+class ByteWriter
+{
+public:
+  std::string& bytes;
+
+  explicit ByteWriter(std::string& out) : bytes(out) { }
+
+  void write(int64_t n)
+  {
+    bytes.append(reinterpret_cast<const char*>(&n), sizeof(n));
+  }
+
+  void write(int n)
+  {
+    write(static_cast<int64_t>(n));
+  }
+
+  void write(const std::string& str)
+  {
+    write(static_cast<int64_t>(str.size()));
+    bytes.append(str);
+  }
+};
+
+class ByteReader
+{
+public:
+  std::string_view bytes;
+
+  explicit ByteReader(std::string_view in) : bytes(in) { }
+
+  int64_t readInt64()
+  {
+    int64_t n;
+    std::memcpy(&n, take(sizeof(n)), sizeof(n));
+    return n;
+  }
+
+  int readInt()
+  {
+    return static_cast<int>(readInt64());
+  }
+
+  size_t readSize()
+  {
+    int64_t n = readInt64();
+
+    if (n < 0 || static_cast<uint64_t>(n) > bytes.size())
+      throw std::runtime_error("malformed indexing result");
+
+    return static_cast<size_t>(n);
+  }
+
+  std::string readString()
+  {
+    size_t n = readSize();
+    return std::string(take(n), n);
+  }
+
+protected:
+  const char* take(size_t n)
+  {
+    if (bytes.size() < n)
+      throw std::runtime_error("truncated indexing result");
+
+    const char* p = bytes.data();
+    bytes.remove_prefix(n);
+    return p;
+  }
+};
+
+} // namespace
+
+/**
+ * \brief serializes an indexing result
+ * \param result  the indexing result
+ * \param bytes   the string to which the bytes are appended
+ * 
+ * The source translation unit and the new files of \a result are not 
+ * serialized: workers do not collect new files (see Indexer::collect_new_files).
+ * 
+ * \sa deserialize().
+ */
+void serialize(const IndexingResult& result, std::string& bytes)
+{
+  ByteWriter w{ bytes };
+
+  w.write(static_cast<int64_t>(result.indexing_time.count()));
+
+  w.write(static_cast<int64_t>(result.includes.size()));
+
+  for (const Include& inc : result.includes)
+  {
+    w.write(inc.file_id.value());
+    w.write(inc.line);
+    w.write(inc.included_file_id.value());
+  }
+
+  w.write(static_cast<int64_t>(result.symbols.size()));
+
+  for (const std::shared_ptr<Symbol>& sym : result.symbols)
+  {
+    w.write(sym->id.value());
+    w.write(static_cast<int>(sym->kind));
+    w.write(sym->name);
+    w.write(sym->usr);
+    w.write(sym->display_name);
+    w.write(sym->parent_id.value());
+    w.write(sym->flags);
+  }
+
+  w.write(static_cast<int64_t>(result.references.size()));
+
+  for (const SymbolReference& ref : result.references)
+  {
+    w.write(ref.symbol_id.value());
+    w.write(ref.file_id.value());
+    w.write(ref.line);
+    w.write(ref.col);
+    w.write(ref.parent_symbol_id.value());
+    w.write(ref.flags);
+  }
+
+  w.write(static_cast<int64_t>(result.bases.size()));
+
+  for (const std::pair<const SymbolId, std::vector<BaseClass>>& p : result.bases)
+  {
+    w.write(p.first.value());
+    w.write(static_cast<int64_t>(p.second.size()));
+
+    for (const BaseClass& b : p.second)
+    {
+      w.write(static_cast<int>(b.access_specifier));
+      w.write(b.base_id.value());
+    }
+  }
+}
+
+/**
+ * \brief reads an indexing result produced by serialize()
+ * \param bytes   the serialized result
+ * \param result  the indexing result to fill
+ * 
+ * The source translation unit of \a result is left unchanged.
+ * Throws std::runtime_error if \a bytes is not a valid serialized result.
+ */
+void deserialize(std::string_view bytes, IndexingResult& result)
+{
+  ByteReader r{ bytes };
+
+  result.indexing_time = std::chrono::milliseconds(r.readInt64());
+
+  for (size_t n = r.readSize(); n > 0; --n)
+  {
+    Include inc;
+    inc.file_id = FileId(r.readInt64());
+    inc.line = r.readInt();
+    inc.included_file_id = FileId(r.readInt64());
+    result.includes.push_back(inc);
+  }
+
+  for (size_t n = r.readSize(); n > 0; --n)
+  {
+    auto sym = std::make_shared<Symbol>();
+    sym->id = SymbolId(r.readInt64());
+    sym->kind = static_cast<Whatsit>(r.readInt());
+    sym->name = r.readString();
+    sym->usr = r.readString();
+    sym->display_name = r.readString();
+    sym->parent_id = SymbolId(r.readInt64());
+    sym->flags = r.readInt();
+    result.symbols.push_back(std::move(sym));
+  }
+
+  for (size_t n = r.readSize(); n > 0; --n)
+  {
+    SymbolReference ref;
+    ref.symbol_id = SymbolId(r.readInt64());
+    ref.file_id = FileId(r.readInt64());
+    ref.line = r.readInt();
+    ref.col = r.readInt();
+    ref.parent_symbol_id = SymbolId(r.readInt64());
+    ref.flags = r.readInt();
+    result.references.push_back(ref);
+  }
+
+  for (size_t n = r.readSize(); n > 0; --n)
+  {
+    std::vector<BaseClass>& bases = result.bases[SymbolId(r.readInt64())];
+
+    for (size_t m = r.readSize(); m > 0; --m)
+    {
+      BaseClass b;
+      b.access_specifier = static_cast<AccessSpecifier>(r.readInt());
+      b.base_id = SymbolId(r.readInt64());
+      bases.push_back(b);
+    }
+  }
+
+  if (!r.bytes.empty())
+    throw std::runtime_error("malformed indexing result");
+}
+
+} // namespace csnap
@@ -13,28 +13,38 @@
 #include <vcxproj/utils.h>
 
 #include <iostream>
+#include <set>
 
 namespace csnap
 {
 
 static void listFiles(Snapshot& ss, const vcxproj::Solution& solution)
 {
-  std::vector<File> files;
+  // files that are already in the snapshot (e.g., when updating a snapshot, 
+  // or when a file is listed in several projects) are skipped.
+  auto add_file = [&ss](std::string f) {
+    if (!ss.findFile(f))
+      ss.addFile(create_file(std::move(f)));
+  };
 
   for (const vcxproj::Project& p : solution.projects)
   {
     for (std::string f : p.includeList)
-      files.push_back(create_file(std::move(f)));
+      add_file(std::move(f));
 
     for (std::string f : p.compileList)
-      files.push_back(create_file(std::move(f)));
+      add_file(std::move(f));
   }
-
-  ss.addFiles(files);
 }
 
 static void listTranslationUnits(Snapshot& ss, const vcxproj::Solution& solution)
 {
+  // source files that already have a translation unit in the snapshot
+  std::set<FileId> sources;
+
+  for (TranslationUnit* tu : ss.translationUnits().all())
+    sources.insert(tu->sourcefile_id);
+
   for (const vcxproj::Project& p : solution.projects)
   {
     if (p.itemDefinitionGroupList.empty())
@@ -87,6 +97,9 @@ static void listTranslationUnits(Snapshot& ss, const vcxproj::Solution& solution
         continue;
       }
 
+      if (!sources.insert(file->id).second)
+        continue;
+
       list.push_back(file->id);
     }
 
@@ -101,6 +114,7 @@ static void listTranslationUnits(Snapshot& ss, const vcxproj::Solution& solution
  * 
  * This function lists the file and translation units in the various projects 
  * of the solution and adds them to the snapshot.
+ * Files and translation units that are already in the snapshot are not added again.
  */
 void openSln(const std::filesystem::path& path, Snapshot& snapshot)
 {
@@ -0,0 +1,121 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#include "snapshotwriter.h"
+
+#include "csnap/database/snapshot.h"
+
+namespace csnap
+{
+
+/**
+ * \brief starts a writer thread for a snapshot
+ * \param s  the snapshot
+ */
+SnapshotWriter::SnapshotWriter(Snapshot& s) :
+  m_snapshot(s),
+  // at most two groups wait to be written, the thread producing the data 
+  // is blocked in flush() if the writer falls behind
+  m_queue(2),
+  m_last_flush(std::chrono::steady_clock::now())
+{
+  m_thread = std::thread(&SnapshotWriter::run, this);
+}
+
+/**
+ * \brief writes all remaining data and stops the writer thread
+ */
+SnapshotWriter::~SnapshotWriter()
+{
+  flush();
+  m_queue.write(nullptr);
+  m_thread.join();
+}
+
+/**
+ * \brief returns the snapshot passed to the constructor
+ */
+Snapshot& SnapshotWriter::snapshot() const
+{
+  return m_snapshot;
+}
+
+/**
+ * \brief hands over the pending data of the snapshot if needed
+ * 
+ * This function should be called after data was added to the snapshot.
+ * The pending data is sent to the writer thread if it contains at least 
+ * \a max_pending_rows rows or if the last write happened more than 
+ * \a max_delay ago.
+ */
+void SnapshotWriter::update()
+{
+  if (!snapshot().hasPendingData())
+    return;
+
+  if (snapshot().pendingRowCount() >= max_pending_rows
+    || std::chrono::steady_clock::now() - m_last_flush >= max_delay)
+  {
+    flush();
+  }
+}
+
+/**
+ * \brief hands over all the pending data of the snapshot to the writer thread
+ * 
+ * This function does not wait for the data to be written; 
+ * it may block if the writer thread has too many groups waiting to be written.
+ */
+void SnapshotWriter::flush()
+{
+  m_last_flush = std::chrono::steady_clock::now();
+
+  std::unique_ptr<PendingData> data = snapshot().takePendingData();
+
+  if (!data)
+    return;
+
+  {
+    std::lock_guard lock{ m_mutex };
+    ++m_nb_sent;
+  }
+
+  m_queue.write(std::move(data));
+}
+
+/**
+ * \brief writes all pending data and waits for the writer thread to be done
+ */
+void SnapshotWriter::sync()
+{
+  flush();
+
+  std::unique_lock lock{ m_mutex };
+
+  m_cv.wait(lock, [this]() {
+    return m_nb_written == m_nb_sent;
+    });
+}
+
+void SnapshotWriter::run()
+{
+  for (;;)
+  {
+    std::unique_ptr<PendingData> data = m_queue.next();
+
+    if (!data)
+      return;
+
+    snapshot().write(*data);
+
+    {
+      std::lock_guard lock{ m_mutex };
+      ++m_nb_written;
+    }
+
+    m_cv.notify_all();
+  }
+}
+
+} // namespace csnap
@@ -0,0 +1,1049 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#include "worker.h"
+
+#include "indexer.h"
+#include "parser.h"
+#include "serialization.h"
+
+#include "csnap/database/snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <array>
+#include <cstdio>
+#include <io.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace csnap
+{
+
+// Protocol between a WorkerPool and a worker:
+// - the pool writes the id of a translation unit (8 bytes) on the standard
+//   input of the worker;
+// - the worker answers on its standard output with a frame made of the size
+//   of a payload (8 bytes) followed by the payload: the id of the translation
+//   unit, a status, the parsing time, the path of the saved AST and the
+//   serialized indexing result.
+// The worker exits when its standard input is closed.
+
+namespace
+{
+
+enum FrameStatus : int64_t
+{
+  FrameIndexed = 0,
+  FrameParsingFailed = 1,
+};
+
+void append_int64(std::string& out, int64_t n)
+{
+  out.append(reinterpret_cast<const char*>(&n), sizeof(n));
+}
+
+int64_t read_int64(std::string_view& in)
+{
+  if (in.size() < sizeof(int64_t))
+    throw std::runtime_error("truncated message from worker");
+
+  int64_t n;
+  std::memcpy(&n, in.data(), sizeof(n));
+  in.remove_prefix(sizeof(n));
+  return n;
+}
+
+// the file in which a worker saves the AST of a translation unit
+std::filesystem::path ast_file_path(int pid, int64_t id)
+{
+  return std::filesystem::temp_directory_path() / (std::to_string(pid) + "-" + std::to_string(id) + ".cxxtranslationunit");
+}
+
+void remove_ast_file(int pid, const TranslationUnit* task)
+{
+  if (!task)
+    return;
+
+  std::error_code ec;
+  std::filesystem::remove(ast_file_path(pid, task->id.value()), ec);
+}
+
+#ifdef _WIN32
+
+using NativeHandle = HANDLE;
+
+bool read_all(HANDLE h, void* data, size_t n)
+{
+  char* p = static_cast<char*>(data);
+
+  while (n > 0)
+  {
+    DWORD r = 0;
+
+    if (!::ReadFile(h, p, static_cast<DWORD>(std::min<size_t>(n, 1 << 30)), &r, nullptr) || r == 0)
+      return false;
+
+    p += r;
+    n -= r;
+  }
+
+  return true;
+}
+
+bool write_all(HANDLE h, const void* data, size_t n)
+{
+  const char* p = static_cast<const char*>(data);
+
+  while (n > 0)
+  {
+    DWORD r = 0;
+
+    if (!::WriteFile(h, p, static_cast<DWORD>(std::min<size_t>(n, 1 << 30)), &r, nullptr))
+      return false;
+
+    p += r;
+    n -= r;
+  }
+
+  return true;
+}
+
+void close_handle(HANDLE h)
+{
+  ::CloseHandle(h);
+}
+
+int current_process_id()
+{
+  return static_cast<int>(::GetCurrentProcessId());
+}
+
+// returns a handle to the standard output, which then writes to the standard error
+HANDLE redirect_stdout()
+{
+  HANDLE output = nullptr;
+  ::DuplicateHandle(::GetCurrentProcess(), ::GetStdHandle(STD_OUTPUT_HANDLE),
+    ::GetCurrentProcess(), &output, 0, FALSE, DUPLICATE_SAME_ACCESS);
+
+  ::SetStdHandle(STD_OUTPUT_HANDLE, ::GetStdHandle(STD_ERROR_HANDLE));
+  ::_dup2(::_fileno(stderr), ::_fileno(stdout));
+
+  return output;
+}
+
+std::string describe_exit_status(int status)
+{
+  auto code = static_cast<unsigned long>(static_cast<DWORD>(status));
+
+  // NTSTATUS error codes, e.g. 0xC0000005 for an access violation
+  if (code >= 0xC0000000UL)
+  {
+    char hex[16];
+    std::snprintf(hex, sizeof(hex), "0x%08lX", code);
+    return std::string("terminated by exception ") + hex;
+  }
+
+  return "exited with code " + std::to_string(code);
+}
+
+// quotes an argument so that it is parsed back by CommandLineToArgvW()
+// and the C runtime
+std::wstring quote_argument(const std::wstring& arg)
+{
+  if (!arg.empty() && arg.find_first_of(L" \t\n\v\"") == std::wstring::npos)
+    return arg;
+
+  std::wstring r = L"\"";
+
+  for (auto it = arg.begin(); ; ++it)
+  {
+    size_t backslashes = 0;
+
+    while (it != arg.end() && *it == L'\\')
+    {
+      ++it;
+      ++backslashes;
+    }
+
+    if (it == arg.end())
+    {
+      // backslashes before the closing quote must be escaped
+      r.append(2 * backslashes, L'\\');
+      break;
+    }
+    else if (*it == L'"')
+    {
+      r.append(2 * backslashes + 1, L'\\');
+      r.push_back(*it);
+    }
+    else
+    {
+      r.append(backslashes, L'\\');
+      r.push_back(*it);
+    }
+  }
+
+  r.push_back(L'"');
+  return r;
+}
+
+std::wstring command_line(const std::vector<std::string>& command)
+{
+  std::wstring r;
+
+  for (const std::string& arg : command)
+  {
+    if (!r.empty())
+      r.push_back(L' ');
+
+    r += quote_argument(std::filesystem::u8path(arg).wstring());
+  }
+
+  return r;
+}
+
+#else
+
+using NativeHandle = int;
+
+bool read_all(int fd, void* data, size_t n)
+{
+  char* p = static_cast<char*>(data);
+
+  while (n > 0)
+  {
+    ssize_t r = ::read(fd, p, n);
+
+    if (r < 0 && errno == EINTR)
+      continue;
+    else if (r <= 0)
+      return false;
+
+    p += r;
+    n -= static_cast<size_t>(r);
+  }
+
+  return true;
+}
+
+bool write_all(int fd, const void* data, size_t n)
+{
+  const char* p = static_cast<const char*>(data);
+
+  while (n > 0)
+  {
+    ssize_t r = ::write(fd, p, n);
+
+    if (r < 0 && errno == EINTR)
+      continue;
+    else if (r < 0)
+      return false;
+
+    p += r;
+    n -= static_cast<size_t>(r);
+  }
+
+  return true;
+}
+
+void close_handle(int fd)
+{
+  ::close(fd);
+}
+
+int current_process_id()
+{
+  return static_cast<int>(::getpid());
+}
+
+// returns a descriptor of the standard output, which then writes to the standard error
+int redirect_stdout()
+{
+  int output = ::dup(STDOUT_FILENO);
+  ::dup2(STDERR_FILENO, STDOUT_FILENO);
+  return output;
+}
+
+std::string describe_exit_status(int status)
+{
+  if (WIFSIGNALED(status))
+    return "terminated by signal " + std::to_string(WTERMSIG(status));
+  else if (WIFEXITED(status))
+    return "exited with code " + std::to_string(WEXITSTATUS(status));
+  else
+    return "terminated";
+}
+
+#endif // _WIN32
+
+} // namespace
+
+/**
+ * \brief constructs a worker
+ * \param s  the snapshot containing the translation units to process
+ */
+Worker::Worker(Snapshot& s) :
+  m_snapshot(s)
+{
+
+}
+
+/**
+ * \brief processes translation units until the standard input is closed
+ *
+ * Everything that is written on the standard output while this function
+ * runs (e.g., progress messages) is redirected to the standard error
+ * so that it does not get mixed with the results.
+ */
+void Worker::run()
+{
+#ifdef _WIN32
+  NativeHandle input = ::GetStdHandle(STD_INPUT_HANDLE);
+#else
+  NativeHandle input = STDIN_FILENO;
+#endif
+
+  NativeHandle output = redirect_stdout();
+
+  libclang::LibClang clang;
+  libclang::Index index = clang.createIndex();
+
+  Parser parser{ index, m_snapshot.files() };
+  Indexer indexer{ index, m_snapshot };
+
+  int64_t id;
+
+  while (read_all(input, &id, sizeof(id)))
+  {
+    TranslationUnit* tu = m_snapshot.getTranslationUnit(TranslationUnitId(id));
+
+    if (!tu)
+      throw std::runtime_error("unknown translation unit " + std::to_string(id));
+
+    parser.asyncParse(tu);
+    TranslationUnitParsingResult pr{ parser.results().next() };
+    std::chrono::milliseconds parsing_time = pr.parsing_time;
+
+    std::string frame;
+    append_int64(frame, 0); // size of the payload, written below
+    append_int64(frame, id);
+
+    if (pr.result)
+    {
+      std::filesystem::path astfile;
+
+      if (save_ast)
+      {
+        astfile = ast_file_path(current_process_id(), id);
+        pr.result->saveTranslationUnit(astfile.string());
+      }
+
+      indexer.asyncIndex(std::move(pr));
+      IndexingResult idxres{ indexer.results().next() };
+
+      append_int64(frame, FrameIndexed);
+      append_int64(frame, parsing_time.count());
+      std::string astpath = astfile.u8string();
+      append_int64(frame, static_cast<int64_t>(astpath.size()));
+      frame.append(astpath);
+      serialize(idxres, frame);
+    }
+    else
+    {
+      append_int64(frame, FrameParsingFailed);
+      append_int64(frame, parsing_time.count());
+      append_int64(frame, 0);
+    }
+
+    int64_t payload_size = static_cast<int64_t>(frame.size() - sizeof(int64_t));
+    std::memcpy(frame.data(), &payload_size, sizeof(payload_size));
+
+    if (!write_all(output, frame.data(), frame.size()))
+      break;
+  }
+
+  close_handle(output);
+}
+
+struct WorkerPool::Process
+{
+  int pid = -1; // -1 if the process is not running
+#ifdef _WIN32
+  HANDLE handle = nullptr;
+  HANDLE input = nullptr; // write end of the standard input of the worker
+  HANDLE output = nullptr; // read end of the standard output of the worker
+  // the output is read asynchronously, one chunk at a time
+  OVERLAPPED overlapped = {};
+  bool reading = false;
+  std::array<char, 64 * 1024> chunk;
+#else
+  int input = -1; // write end of the standard input of the worker
+  int output = -1; // read end of the standard output of the worker
+#endif
+  TranslationUnit* task = nullptr;
+  std::chrono::steady_clock::time_point deadline;
+  std::string buffer;
+};
+
+/**
+ * \brief constructs a pool of worker processes
+ * \param command  the program and arguments used to start a worker
+ * \param n        the number of worker processes
+ *
+ * The processes are started when translation units are submitted.
+ * The command is expected to run a Worker (see the "csnap worker" command).
+ * On Windows, there can be at most 64 worker processes.
+ */
+WorkerPool::WorkerPool(std::vector<std::string> command, size_t n) :
+  m_command(std::move(command))
+{
+  if (m_command.empty())
+    throw std::runtime_error("empty worker command");
+
+#ifdef _WIN32
+  // limit of WaitForMultipleObjects(), see next()
+  n = std::min(n, size_t(MAXIMUM_WAIT_OBJECTS));
+#else
+  // A worker may exit while we are writing to it; write() should then
+  // fail with EPIPE instead of terminating the program.
+  std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+  for (size_t i(0); i < std::max(n, size_t(1)); ++i)
+  {
+    m_processes.push_back(std::make_unique<Process>());
+  }
+}
+
+/**
+ * \brief stops all the worker processes
+ *
+ * Workers that are still processing a translation unit are killed.
+ */
+WorkerPool::~WorkerPool()
+{
+  for (std::unique_ptr<Process>& p : m_processes)
+  {
+    stop(*p, p->task != nullptr);
+  }
+}
+
+/**
+ * \brief returns the time a worker is allowed to spend on a translation unit
+ *
+ * A value of zero means that there is no limit.
+ */
+std::chrono::milliseconds WorkerPool::timeout() const
+{
+  return m_timeout;
+}
+
+/**
+ * \brief sets the time a worker is allowed to spend on a translation unit
+ * \param timeout  the time limit, zero for no limit
+ *
+ * The limit covers both the parsing and the indexing of the translation unit.
+ */
+void WorkerPool::setTimeout(std::chrono::milliseconds timeout)
+{
+  m_timeout = timeout;
+}
+
+/**
+ * \brief adds a translation unit to the list of translation units to process
+ *
+ * Translation units are sent to the workers in the order in which they
+ * are submitted.
+ */
+void WorkerPool::submit(TranslationUnit* tu)
+{
+  m_queue.push_back(tu);
+  ++m_nb_pending;
+}
+
+/**
+ * \brief returns the number of submitted translation units whose result has not been returned by next()
+ */
+size_t WorkerPool::pendingCount() const
+{
+  return m_nb_pending;
+}
+
+/**
+ * \brief returns the number of workers that were replaced after a crash or a timeout
+ */
+size_t WorkerPool::restartCount() const
+{
+  return m_nb_restarts;
+}
+
+#ifdef _WIN32
+
+/**
+ * \brief waits for the next translation unit to be processed
+ *
+ * Every submitted translation unit produces exactly one result, whose
+ * status tells whether the translation unit was indexed.
+ *
+ * \warning pendingCount() must be greater than zero.
+ */
+WorkerResult WorkerPool::next()
+{
+  if (pendingCount() == 0)
+    throw std::runtime_error("no translation unit to wait for");
+
+  WorkerResult result;
+
+  for (;;)
+  {
+    dispatch();
+
+    std::vector<HANDLE> events;
+    std::vector<Process*> busy;
+
+    for (std::unique_ptr<Process>& p : m_processes)
+    {
+      if (!p->task)
+        continue;
+
+      if (!p->reading)
+      {
+        // the event is reset by ReadFile() and set once the read completes
+        if (!::ReadFile(p->output, p->chunk.data(), static_cast<DWORD>(p->chunk.size()), nullptr, &p->overlapped)
+          && ::GetLastError() != ERROR_IO_PENDING)
+        {
+          // the worker closed its output, it exited or is about to
+          return fail(*p, WorkerResult::Crashed, "worker " + describe_exit_status(stop(*p, false)));
+        }
+
+        p->reading = true;
+      }
+
+      events.push_back(p->overlapped.hEvent);
+      busy.push_back(p.get());
+    }
+
+    int wait = waitTime();
+    DWORD r = ::WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE, wait < 0 ? INFINITE : static_cast<DWORD>(wait));
+
+    if (r == WAIT_FAILED)
+      throw std::runtime_error("could not wait for the worker processes");
+
+    if (r < WAIT_OBJECT_0 + events.size())
+    {
+      Process& p = *busy[r - WAIT_OBJECT_0];
+      DWORD n = 0;
+      BOOL ok = ::GetOverlappedResult(p.output, &p.overlapped, &n, FALSE);
+      p.reading = false;
+
+      if (!ok)
+        return fail(p, WorkerResult::Crashed, "worker " + describe_exit_status(stop(p, false)));
+
+      if (consume(p, p.chunk.data(), n, result))
+        return result;
+    }
+
+    if (checkDeadlines(result))
+      return result;
+  }
+}
+
+/**
+ * \brief starts a worker process
+ */
+void WorkerPool::start(Process& p)
+{
+  static int nb_pipes = 0;
+
+  // The output of the worker is read with overlapped I/O, which anonymous
+  // pipes do not support, so a named pipe is used instead.
+  std::wstring name = L"\\\\.\\pipe\\csnap-worker-" + std::to_wstring(::GetCurrentProcessId()) + L"-" + std::to_wstring(nb_pipes++);
+
+  // the ends used by the worker are inherited, the ends used by the pool are not
+  SECURITY_ATTRIBUTES inherit = {};
+  inherit.nLength = sizeof(inherit);
+  inherit.bInheritHandle = TRUE;
+
+  HANDLE output = ::CreateNamedPipeW(name.c_str(), PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+    PIPE_TYPE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS, 1, 64 * 1024, 64 * 1024, 0, nullptr);
+
+  if (output == INVALID_HANDLE_VALUE)
+    throw std::runtime_error("could not create pipe for worker process");
+
+  HANDLE child_output = ::CreateFileW(name.c_str(), GENERIC_WRITE, 0, &inherit, OPEN_EXISTING, 0, nullptr);
+
+  if (child_output == INVALID_HANDLE_VALUE)
+  {
+    ::CloseHandle(output);
+    throw std::runtime_error("could not create pipe for worker process");
+  }
+
+  HANDLE child_input = nullptr;
+  HANDLE input = nullptr;
+
+  if (!::CreatePipe(&child_input, &input, &inherit, 0))
+  {
+    ::CloseHandle(output);
+    ::CloseHandle(child_output);
+    throw std::runtime_error("could not create pipe for worker process");
+  }
+
+  ::SetHandleInformation(input, HANDLE_FLAG_INHERIT, 0);
+
+  STARTUPINFOW si = {};
+  si.cb = sizeof(si);
+  si.dwFlags = STARTF_USESTDHANDLES;
+  si.hStdInput = child_input;
+  si.hStdOutput = child_output;
+  si.hStdError = ::GetStdHandle(STD_ERROR_HANDLE);
+
+  PROCESS_INFORMATION pi = {};
+  std::wstring cmdline = command_line(m_command);
+
+  BOOL started = ::CreateProcessW(nullptr, cmdline.data(), nullptr, nullptr, TRUE, 0, nullptr, nullptr, &si, &pi);
+
+  ::CloseHandle(child_input);
+  ::CloseHandle(child_output);
+
+  if (!started)
+  {
+    ::CloseHandle(input);
+    ::CloseHandle(output);
+    throw std::runtime_error("could not start worker process");
+  }
+
+  ::CloseHandle(pi.hThread);
+
+  p.pid = static_cast<int>(pi.dwProcessId);
+  p.handle = pi.hProcess;
+  p.input = input;
+  p.output = output;
+  p.overlapped = {};
+  p.overlapped.hEvent = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+  p.reading = false;
+  p.task = nullptr;
+  p.buffer.clear();
+}
+
+/**
+ * \brief stops a worker process
+ * \param p     the process
+ * \param kill  whether the process should be killed instead of being asked to exit
+ * \return the exit code of the process
+ *
+ * If the process was processing a translation unit, the AST it may have
+ * saved for it is removed.
+ */
+int WorkerPool::stop(Process& p, bool kill)
+{
+  if (p.pid < 0)
+    return 0;
+
+  if (kill)
+    ::TerminateProcess(p.handle, 1);
+
+  ::CloseHandle(p.input);
+
+  if (p.reading)
+  {
+    // the buffer must not be released while the read is in progress
+    DWORD n = 0;
+    ::CancelIoEx(p.output, &p.overlapped);
+    ::GetOverlappedResult(p.output, &p.overlapped, &n, TRUE);
+    p.reading = false;
+  }
+
+  ::CloseHandle(p.output);
+  ::CloseHandle(p.overlapped.hEvent);
+
+  ::WaitForSingleObject(p.handle, INFINITE);
+
+  DWORD status = 0;
+  ::GetExitCodeProcess(p.handle, &status);
+  ::CloseHandle(p.handle);
+
+  remove_ast_file(p.pid, p.task);
+
+  p.pid = -1;
+  p.handle = nullptr;
+  p.input = nullptr;
+  p.output = nullptr;
+  p.overlapped = {};
+  p.buffer.clear();
+
+  return static_cast<int>(status);
+}
+
+#else
+
+/**
+ * \brief waits for the next translation unit to be processed
+ *
+ * Every submitted translation unit produces exactly one result, whose
+ * status tells whether the translation unit was indexed.
+ *
+ * \warning pendingCount() must be greater than zero.
+ */
+WorkerResult WorkerPool::next()
+{
+  if (pendingCount() == 0)
+    throw std::runtime_error("no translation unit to wait for");
+
+  WorkerResult result;
+
+  for (;;)
+  {
+    dispatch();
+
+    std::vector<pollfd> fds;
+    std::vector<Process*> busy;
+
+    for (std::unique_ptr<Process>& p : m_processes)
+    {
+      if (!p->task)
+        continue;
+
+      fds.push_back(pollfd{ p->output, POLLIN, 0 });
+      busy.push_back(p.get());
+    }
+
+    int r = ::poll(fds.data(), static_cast<nfds_t>(fds.size()), waitTime());
+
+    if (r < 0 && errno != EINTR)
+      throw std::runtime_error("could not wait for the worker processes");
+
+    for (size_t i(0); r > 0 && i < fds.size(); ++i)
+    {
+      if (fds[i].revents == 0)
+        continue;
+
+      Process& p = *busy[i];
+      char chunk[64 * 1024];
+      ssize_t n = ::read(p.output, chunk, sizeof(chunk));
+
+      if (n < 0 && errno == EINTR)
+        continue;
+
+      if (n <= 0)
+      {
+        // the worker closed its output, it exited or is about to
+        return fail(p, WorkerResult::Crashed, "worker " + describe_exit_status(stop(p, false)));
+      }
+
+      if (consume(p, chunk, static_cast<size_t>(n), result))
+        return result;
+    }
+
+    if (checkDeadlines(result))
+      return result;
+  }
+}
+
+/**
+ * \brief starts a worker process
+ */
+void WorkerPool::start(Process& p)
+{
+  int to_worker[2];
+  int from_worker[2];
+
+  if (::pipe(to_worker) != 0)
+    throw std::runtime_error("could not create pipe for worker process");
+
+  if (::pipe(from_worker) != 0)
+  {
+    ::close(to_worker[0]);
+    ::close(to_worker[1]);
+    throw std::runtime_error("could not create pipe for worker process");
+  }
+
+  // The ends used by the pool must not be inherited by the other workers,
+  // otherwise a worker would not see the end of its input when the pool
+  // closes it.
+  ::fcntl(to_worker[1], F_SETFD, FD_CLOEXEC);
+  ::fcntl(from_worker[0], F_SETFD, FD_CLOEXEC);
+
+  std::vector<char*> argv;
+
+  for (std::string& arg : m_command)
+    argv.push_back(arg.data());
+
+  argv.push_back(nullptr);
+
+  pid_t pid = ::fork();
+
+  if (pid < 0)
+  {
+    ::close(to_worker[0]);
+    ::close(to_worker[1]);
+    ::close(from_worker[0]);
+    ::close(from_worker[1]);
+    throw std::runtime_error("could not start worker process");
+  }
+
+  if (pid == 0)
+  {
+    ::dup2(to_worker[0], STDIN_FILENO);
+    ::dup2(from_worker[1], STDOUT_FILENO);
+    ::close(to_worker[0]);
+    ::close(to_worker[1]);
+    ::close(from_worker[0]);
+    ::close(from_worker[1]);
+    ::execvp(argv[0], argv.data());
+    ::_exit(127);
+  }
+
+  ::close(to_worker[0]);
+  ::close(from_worker[1]);
+
+  p.pid = static_cast<int>(pid);
+  p.input = to_worker[1];
+  p.output = from_worker[0];
+  p.task = nullptr;
+  p.buffer.clear();
+}
+
+/**
+ * \brief stops a worker process
+ * \param p     the process
+ * \param kill  whether the process should be killed instead of being asked to exit
+ * \return the exit status of the process, as returned by waitpid()
+ *
+ * If the process was processing a translation unit, the AST it may have
+ * saved for it is removed.
+ */
+int WorkerPool::stop(Process& p, bool kill)
+{
+  if (p.pid < 0)
+    return 0;
+
+  if (kill)
+    ::kill(p.pid, SIGKILL);
+
+  ::close(p.input);
+  ::close(p.output);
+
+  int status = 0;
+
+  while (::waitpid(p.pid, &status, 0) < 0 && errno == EINTR)
+    continue;
+
+  remove_ast_file(p.pid, p.task);
+
+  p.pid = -1;
+  p.input = -1;
+  p.output = -1;
+  p.buffer.clear();
+
+  return status;
+}
+
+#endif // _WIN32
+
+/**
+ * \brief sends a translation unit to a worker process
+ * \return whether the translation unit could be sent
+ */
+bool WorkerPool::send(Process& p, TranslationUnit* tu)
+{
+  int64_t id = tu->id.value();
+
+  if (!write_all(p.input, &id, sizeof(id)))
+    return false;
+
+  p.task = tu;
+  p.deadline = std::chrono::steady_clock::now() + m_timeout;
+  return true;
+}
+
+/**
+ * \brief sends the queued translation units to the idle workers
+ */
+void WorkerPool::dispatch()
+{
+  for (std::unique_ptr<Process>& p : m_processes)
+  {
+    if (m_queue.empty())
+      return;
+
+    if (p->task)
+      continue;
+
+    if (p->pid < 0)
+      start(*p);
+
+    if (!send(*p, m_queue.front()))
+    {
+      // the worker exited while it was idle, we try again with a new one
+      stop(*p, true);
+      ++m_nb_restarts;
+      start(*p);
+
+      if (!send(*p, m_queue.front()))
+        throw std::runtime_error("could not send translation unit to worker process");
+    }
+
+    m_queue.pop_front();
+  }
+}
+
+/**
+ * \brief returns how long next() may wait for data before a worker exceeds its time limit
+ * \return a duration in milliseconds, or -1 if there is no limit
+ */
+int WorkerPool::waitTime() const
+{
+  if (m_timeout.count() <= 0)
+    return -1;
+
+  int wait = -1;
+  auto now = std::chrono::steady_clock::now();
+
+  for (const std::unique_ptr<Process>& p : m_processes)
+  {
+    if (!p->task)
+      continue;
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(p->deadline - now).count() + 1;
+    int ms = static_cast<int>(std::max<decltype(remaining)>(remaining, 0));
+    wait = wait < 0 ? ms : std::min(wait, ms);
+  }
+
+  return wait;
+}
+
+/**
+ * \brief appends data received from a worker to its buffer
+ * \param p       the worker process
+ * \param data    the data
+ * \param size    the number of bytes
+ * \param result  receives the result, if any
+ * \return true if \a result was filled
+ *
+ * A worker that sends an invalid result is in an unknown state; it is
+ * stopped and its translation unit is reported as crashed.
+ */
+bool WorkerPool::consume(Process& p, const char* data, size_t size, WorkerResult& result)
+{
+  p.buffer.append(data, size);
+
+  try
+  {
+    return receive(p, result);
+  }
+  catch (const std::runtime_error& e)
+  {
+    stop(p, true);
+    result = fail(p, WorkerResult::Crashed, std::string("invalid result from worker: ") + e.what());
+    return true;
+  }
+}
+
+/**
+ * \brief kills the first worker that exceeded the time allowed for its translation unit
+ * \param result  receives the result of the translation unit
+ * \return true if a worker was killed
+ */
+bool WorkerPool::checkDeadlines(WorkerResult& result)
+{
+  if (m_timeout.count() <= 0)
+    return false;
+
+  auto now = std::chrono::steady_clock::now();
+
+  for (std::unique_ptr<Process>& p : m_processes)
+  {
+    if (p->task && now >= p->deadline)
+    {
+      stop(*p, true);
+      result = fail(*p, WorkerResult::TimedOut, "timed out after " + std::to_string(m_timeout.count() / 1000) + "s");
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * \brief extracts a result from the data received from a worker
+ * \param p       the worker process
+ * \param result  receives the result
+ * \return true if a complete result was received
+ *
+ * Throws std::runtime_error if the data is not a valid result for the
+ * translation unit being processed by the worker.
+ */
+bool WorkerPool::receive(Process& p, WorkerResult& result)
+{
+  if (p.buffer.size() < sizeof(int64_t))
+    return false;
+
+  std::string_view frame{ p.buffer };
+  size_t size = static_cast<size_t>(read_int64(frame));
+
+  if (frame.size() < size)
+    return false;
+
+  std::string_view payload = frame.substr(0, size);
+
+  if (read_int64(payload) != p.task->id.value())
+    throw std::runtime_error("result for another translation unit");
+
+  result.source = p.task;
+  result.status = read_int64(payload) == FrameIndexed ? WorkerResult::Indexed : WorkerResult::ParsingFailed;
+  result.parsing_time = std::chrono::milliseconds(read_int64(payload));
+
+  size_t astpath_size = static_cast<size_t>(read_int64(payload));
+
+  if (payload.size() < astpath_size)
+    throw std::runtime_error("truncated message from worker");
+
+  result.ast_file = std::filesystem::u8path(std::string(payload.substr(0, astpath_size)));
+  payload.remove_prefix(astpath_size);
+  result.bytes = std::string(payload);
+
+  p.buffer.erase(0, sizeof(int64_t) + size);
+  p.task = nullptr;
+  --m_nb_pending;
+
+  return true;
+}
+
+/**
+ * \brief produces the result of a translation unit whose worker crashed or timed out
+ *
+ * The worker process must have been stopped; a new process is started
+ * the next time a translation unit is sent to the worker.
+ */
+WorkerResult WorkerPool::fail(Process& p, WorkerResult::Status status, std::string error)
+{
+  WorkerResult result;
+  result.source = p.task;
+  result.status = status;
+  result.error = std::move(error);
+
+  p.task = nullptr;
+  --m_nb_pending;
+  ++m_nb_restarts;
+
+  return result;
+}
+
+} // namespace csnap
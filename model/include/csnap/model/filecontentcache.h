@@ -6,30 +6,44 @@
 #define CSNAP_FILECONTENTCACHE_H
 
 #include "filecontent.h"
+#include "lrucache.h"
 
-#include <map>
 #include <memory>
 
 namespace csnap
 {
 
-// $TODO: try refactor with SymbolCache
+/**
+ * \brief a cache of file contents with a memory budget
+ * 
+ * \sa LruCache.
+ */
 class FileContentCache
 {
 public:
+  static constexpr size_t DefaultBudget = 64 * 1024 * 1024;
+
+  FileContentCache();
 
   void insert(std::shared_ptr<FileContent> item);
 
   template<typename It>
   void insert(It begin, It end);
 
-  std::shared_ptr<FileContent> find(FileId itemid) const;
+  std::shared_ptr<FileContent> find(FileId itemid);
+
+  size_t budget() const;
+  void setBudget(size_t bytes);
+  size_t size() const;
+  size_t bytesUsed() const;
+  const CacheStats& stats() const;
 
   void clear();
-  void cleanup();
+
+  static size_t memoryUsage(const FileContent& fc);
 
 private:
-  std::map<int, std::weak_ptr<FileContent>> m_data;
+  LruCache<FileContent> m_data;
 };
 
 template<typename It>
@@ -6,8 +6,12 @@
 #define CSNAP_FILELIST_H
 
 #include "file.h"
+#include "stringarena.h"
 
+#include <functional>
 #include <memory>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace csnap
@@ -15,6 +19,15 @@ namespace csnap
 
 /**
  * \brief stores a list of files
+ * 
+ * The list maintains an index from file path to file id so that find() 
+ * runs in constant time; the paths used as keys are stored in an arena.
+ * The path of a File must therefore not be modified once the file 
+ * has been added to the list.
+ * 
+ * Files added without an id get an id derived from their path 
+ * (see stable_id()); add() throws std::runtime_error if that id is 
+ * already used by another file.
  */
 class FileList
 {
@@ -25,12 +38,19 @@ public:
   std::vector<File*> all() const;
   File* get(Identifier<File> id) const;
 
-  File* find(const std::string& path) const;
+  File* find(std::string_view path) const;
+
+  static FileId newId(std::string_view path, const std::function<bool(FileId)>& is_used);
+
+protected:
+  void index(const File& f);
 
 private:
-  using FilePtr = std::unique_ptr<File>;
   // $TODO: consider another, more cache-friendly way to store the files ?
   std::vector<std::unique_ptr<File>> m_files;
+  std::unordered_map<int64_t, File*> m_ids;
+  StringArena m_paths;
+  std::unordered_map<std::string_view, FileId> m_index;
 
 };
 
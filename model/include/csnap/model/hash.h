@@ -0,0 +1,88 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#ifndef CSNAP_HASH_H
+#define CSNAP_HASH_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace csnap
+{
+
+/**
+ * \brief computes the 64-bit FNV-1a hash of a sequence of bytes
+ * \param bytes  the data to hash
+ * \param h      initial value, can be used to chain several calls
+ */
+inline uint64_t fnv1a_64(std::string_view bytes, uint64_t h = 14695981039346656037ULL)
+{
+  for (char c : bytes)
+  {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ULL;
+  }
+
+  return h;
+}
+
+/**
+ * \brief computes a stable identifier from a key
+ * \param key  the key (e.g., the USR of a symbol or the path of a file)
+ * 
+ * The identifier is a non-negative 63-bit value derived from a hash of 
+ * \a key, so that the same key gets the same id across runs and machines 
+ * without any coordination.
+ * 
+ * Collisions (two different keys with the same id) are not resolved: 
+ * any resolution would depend on the order in which the keys are seen.
+ * Instead, the code assigning the ids (UsrMap, FileList) throws an 
+ * exception when it detects one, so that a set of keys either always 
+ * gets the same ids or always fails.
+ */
+inline int64_t stable_id(std::string_view key)
+{
+  uint64_t h = fnv1a_64(key);
+
+  // FNV-1a does not mix the high bits very well
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  return static_cast<int64_t>(h & 0x7fffffffffffffffULL);
+}
+
+/**
+ * \brief returns a 16-character hexadecimal representation of a hash
+ */
+inline std::string hash_to_string(uint64_t h)
+{
+  static const char digits[] = "0123456789abcdef";
+
+  std::string r(16, '0');
+
+  for (int i(15); i >= 0; --i)
+  {
+    r[i] = digits[h & 0xf];
+    h >>= 4;
+  }
+
+  return r;
+}
+
+/**
+ * \brief computes a hash of the content of a file
+ * \param content  the content of the file
+ */
+inline std::string content_hash(std::string_view content)
+{
+  return hash_to_string(fnv1a_64(content));
+}
+
+} // namespace csnap
+
+#endif // CSNAP_HASH_H
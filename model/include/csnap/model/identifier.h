@@ -5,6 +5,8 @@
 #ifndef CSNAP_IDENTIFIER_H
 #define CSNAP_IDENTIFIER_H
 
+#include <cstdint>
+
 namespace csnap
 {
 
@@ -12,20 +14,20 @@ template<typename T>
 class Identifier
 {
 private:
-  int m_value = -1;
+  int64_t m_value = -1;
 public:
 
   Identifier() = default;
   Identifier(const Identifier<T>&) = default;
   ~Identifier() = default;
 
-  explicit Identifier(int val) :
+  explicit Identifier(int64_t val) :
     m_value(val)
   {
 
   }
 
-  int value() const
+  int64_t value() const
   {
     return m_value;
   }
@@ -0,0 +1,205 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#ifndef CSNAP_LRUCACHE_H
+#define CSNAP_LRUCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace csnap
+{
+
+/**
+ * \brief counters describing the activity of a cache
+ */
+struct CacheStats
+{
+  size_t hits = 0;
+  size_t misses = 0;
+  size_t evictions = 0;
+};
+
+/**
+ * \brief a cache of shared objects indexed by a 64-bit integer id
+ *
+ * The cache holds strong references to its items and evicts the least
+ * recently used items once the total size of the items exceeds a
+ * memory budget (in bytes).
+ * The size of each item is provided by the caller upon insertion.
+ */
+template<typename T>
+class LruCache
+{
+public:
+  explicit LruCache(size_t budget);
+
+  void insert(int64_t id, std::shared_ptr<T> item, size_t bytes);
+  std::shared_ptr<T> find(int64_t id);
+
+  size_t budget() const;
+  void setBudget(size_t bytes);
+
+  size_t size() const;
+  size_t bytesUsed() const;
+  const CacheStats& stats() const;
+
+  void clear();
+
+protected:
+  void evict();
+
+private:
+  struct Entry
+  {
+    int64_t id;
+    std::shared_ptr<T> item;
+    size_t bytes;
+  };
+
+  std::list<Entry> m_entries; // most recently used first
+  std::unordered_map<int64_t, typename std::list<Entry>::iterator> m_index;
+  size_t m_budget;
+  size_t m_bytes = 0;
+  CacheStats m_stats;
+};
+
+template<typename T>
+inline LruCache<T>::LruCache(size_t budget) :
+  m_budget(budget)
+{
+
+}
+
+/**
+ * \brief inserts an item in the cache
+ * \param id     the id of the item
+ * \param item   the item
+ * \param bytes  the (estimated) size of the item in memory
+ *
+ * If an item with the same id is already in the cache, it is replaced.
+ */
+template<typename T>
+inline void LruCache<T>::insert(int64_t id, std::shared_ptr<T> item, size_t bytes)
+{
+  auto it = m_index.find(id);
+
+  if (it != m_index.end())
+  {
+    m_bytes -= it->second->bytes;
+    m_entries.erase(it->second);
+    m_index.erase(it);
+  }
+
+  m_entries.push_front(Entry{ id, std::move(item), bytes });
+  m_index[id] = m_entries.begin();
+  m_bytes += bytes;
+
+  evict();
+}
+
+/**
+ * \brief looks up an item in the cache
+ * \param id  the id of the item
+ * \return the item, or nullptr if it is not in the cache
+ *
+ * On success, the item becomes the most recently used item.
+ */
+template<typename T>
+inline std::shared_ptr<T> LruCache<T>::find(int64_t id)
+{
+  auto it = m_index.find(id);
+
+  if (it == m_index.end())
+  {
+    ++m_stats.misses;
+    return nullptr;
+  }
+
+  ++m_stats.hits;
+  m_entries.splice(m_entries.begin(), m_entries, it->second);
+  return it->second->item;
+}
+
+/**
+ * \brief returns the memory budget of the cache, in bytes
+ */
+template<typename T>
+inline size_t LruCache<T>::budget() const
+{
+  return m_budget;
+}
+
+/**
+ * \brief sets the memory budget of the cache
+ * \param bytes  the budget in bytes
+ *
+ * Items are evicted if the cache exceeds the new budget.
+ */
+template<typename T>
+inline void LruCache<T>::setBudget(size_t bytes)
+{
+  m_budget = bytes;
+  evict();
+}
+
+/**
+ * \brief returns the number of items in the cache
+ */
+template<typename T>
+inline size_t LruCache<T>::size() const
+{
+  return m_entries.size();
+}
+
+/**
+ * \brief returns the total size of the items in the cache
+ */
+template<typename T>
+inline size_t LruCache<T>::bytesUsed() const
+{
+  return m_bytes;
+}
+
+/**
+ * \brief returns the hit, miss and eviction counters of the cache
+ */
+template<typename T>
+inline const CacheStats& LruCache<T>::stats() const
+{
+  return m_stats;
+}
+
+/**
+ * \brief removes all items from the cache
+ *
+ * Counters are not reset.
+ */
+template<typename T>
+inline void LruCache<T>::clear()
+{
+  m_entries.clear();
+  m_index.clear();
+  m_bytes = 0;
+}
+
+template<typename T>
+inline void LruCache<T>::evict()
+{
+  while (m_bytes > m_budget && !m_entries.empty())
+  {
+    const Entry& e = m_entries.back();
+    m_bytes -= e.bytes;
+    m_index.erase(e.id);
+    m_entries.pop_back();
+    ++m_stats.evictions;
+  }
+}
+
+} // namespace csnap
+
+#endif // CSNAP_LRUCACHE_H
@@ -0,0 +1,49 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#ifndef CSNAP_STRINGARENA_H
+#define CSNAP_STRINGARENA_H
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace csnap
+{
+
+/**
+ * \brief stores strings in large contiguous chunks of memory
+ * 
+ * Strings stored in the arena are never moved, the string views returned 
+ * by store() remain valid for the lifetime of the arena (moving the arena 
+ * does not invalidate them).
+ */
+class StringArena
+{
+public:
+  explicit StringArena(size_t chunkSize = 64 * 1024);
+  StringArena(const StringArena&) = delete;
+  StringArena(StringArena&&) = default;
+  ~StringArena() = default;
+
+  std::string_view store(std::string_view str);
+
+  size_t bytesUsed() const;
+
+  void clear();
+
+  StringArena& operator=(const StringArena&) = delete;
+  StringArena& operator=(StringArena&&) = default;
+
+private:
+  size_t m_chunk_size;
+  std::vector<std::unique_ptr<char[]>> m_chunks;
+  char* m_cursor = nullptr;
+  size_t m_remaining = 0;
+  size_t m_bytes_used = 0;
+};
+
+} // namespace csnap
+
+#endif // CSNAP_STRINGARENA_H
@@ -5,30 +5,45 @@
 #ifndef CSNAP_SYMBOLCACHE_H
 #define CSNAP_SYMBOLCACHE_H
 
+#include "lrucache.h"
 #include "symbol.h"
 
-#include <map>
 #include <memory>
 
 namespace csnap
 {
 
+/**
+ * \brief a cache of symbols with a memory budget
+ * 
+ * \sa LruCache.
+ */
 class SymbolCache
 {
 public:
+  static constexpr size_t DefaultBudget = 16 * 1024 * 1024;
+
+  SymbolCache();
 
   void insert(std::shared_ptr<Symbol> s);
 
   template<typename It>
   void insert(It begin, It end);
 
-  std::shared_ptr<Symbol> find(SymbolId symid) const;
+  std::shared_ptr<Symbol> find(SymbolId symid);
+
+  size_t budget() const;
+  void setBudget(size_t bytes);
+  size_t size() const;
+  size_t bytesUsed() const;
+  const CacheStats& stats() const;
 
   void clear();
-  void cleanup();
+
+  static size_t memoryUsage(const Symbol& s);
 
 private:
-  std::map<int, std::weak_ptr<Symbol>> m_data;
+  LruCache<Symbol> m_data;
 };
 
 template<typename It>
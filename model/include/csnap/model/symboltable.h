@@ -0,0 +1,119 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#ifndef CSNAP_SYMBOLTABLE_H
+#define CSNAP_SYMBOLTABLE_H
+
+#include "stringarena.h"
+#include "symbol.h"
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace csnap
+{
+
+/**
+ * \brief read-only table of all the symbols of a snapshot
+ * 
+ * Symbols are stored column-wise: kind, flags and parent are stored 
+ * in arrays and the name, usr and display name of the symbols are 
+ * views into a single StringArena.
+ * A lookup by id does not allocate any memory.
+ * 
+ * Functions taking a SymbolId expect the symbol to be in the table, 
+ * use contains() to check that first.
+ */
+class SymbolTable
+{
+public:
+  SymbolTable();
+  SymbolTable(const SymbolTable&) = delete;
+  SymbolTable(SymbolTable&&) = default;
+  ~SymbolTable() = default;
+
+  void add(const Symbol& s);
+  void add(SymbolId id, Whatsit kind, int flags, SymbolId parent, std::string_view name, std::string_view usr, std::string_view displayname);
+
+  size_t size() const;
+  bool contains(SymbolId id) const;
+
+  Whatsit kind(SymbolId id) const;
+  int flags(SymbolId id) const;
+  SymbolId parent(SymbolId id) const;
+  std::string_view name(SymbolId id) const;
+  std::string_view usr(SymbolId id) const;
+  std::string_view displayName(SymbolId id) const;
+
+  Symbol get(SymbolId id) const;
+
+  SymbolTable& operator=(const SymbolTable&) = delete;
+  SymbolTable& operator=(SymbolTable&&) = default;
+
+protected:
+  size_t row(SymbolId id) const;
+
+private:
+  std::unordered_map<int64_t, size_t> m_rows; // symbol id -> row
+  std::vector<Whatsit> m_kinds;
+  std::vector<int> m_flags;
+  std::vector<SymbolId> m_parents;
+  std::vector<std::string_view> m_names;
+  std::vector<std::string_view> m_usrs;
+  std::vector<std::string_view> m_display_names;
+  StringArena m_strings;
+};
+
+/**
+ * \brief returns the row of a symbol in the columns of the table
+ */
+inline size_t SymbolTable::row(SymbolId id) const
+{
+  return m_rows.find(id.value())->second;
+}
+
+/**
+ * \brief returns whether the table contains a symbol with the given id
+ * \param id  the id of the symbol
+ */
+inline bool SymbolTable::contains(SymbolId id) const
+{
+  return m_rows.find(id.value()) != m_rows.end();
+}
+
+inline Whatsit SymbolTable::kind(SymbolId id) const
+{
+  return m_kinds[row(id)];
+}
+
+inline int SymbolTable::flags(SymbolId id) const
+{
+  return m_flags[row(id)];
+}
+
+inline SymbolId SymbolTable::parent(SymbolId id) const
+{
+  return m_parents[row(id)];
+}
+
+inline std::string_view SymbolTable::name(SymbolId id) const
+{
+  return m_names[row(id)];
+}
+
+inline std::string_view SymbolTable::usr(SymbolId id) const
+{
+  return m_usrs[row(id)];
+}
+
+inline std::string_view SymbolTable::displayName(SymbolId id) const
+{
+  return m_display_names[row(id)];
+}
+
+} // namespace csnap
+
+#endif // CSNAP_SYMBOLTABLE_H
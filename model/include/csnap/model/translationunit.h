@@ -8,6 +8,7 @@
 #include "fileid.h"
 #include "translationunitid.h"
 
+#include <chrono>
 #include <map>
 #include <memory>
 #include <set>
@@ -32,6 +33,14 @@ struct TranslationUnit
   TranslationUnitId id;
   FileId sourcefile_id;
   std::shared_ptr<const program::CompileOptions> compile_options;
+
+  /**
+   * \brief time spent parsing and indexing the translation unit the last time it was scanned
+   * 
+   * Negative values mean that the translation unit was never scanned.
+   */
+  std::chrono::milliseconds parsing_time{ -1 };
+  std::chrono::milliseconds indexing_time{ -1 };
 };
 
 } // namespace csnap
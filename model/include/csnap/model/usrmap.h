@@ -10,6 +10,8 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_map>
 #include <utility>
 
 namespace csnap
@@ -20,6 +22,12 @@ namespace csnap
  * 
  * libclang uses USRs (Unified Symbol Resolution) to match symbols across translation units.
  * This class is used to assign a SymbolId to a USR.
+ * 
+ * Ids are derived from a hash of the USR (see stable_id()), so that a symbol 
+ * gets the same id in every snapshot, whatever the order in which the 
+ * translation units are processed.
+ * Inserting a USR whose id is already used by another USR throws 
+ * std::runtime_error.
  */
 class UsrMap
 {
@@ -28,29 +36,14 @@ public:
   SymbolId find(const std::string& usr) const;
   SymbolId insert(const std::string& usr);
   void insert(const std::string& usr, SymbolId id);
-
-private:
-  std::map<std::string, SymbolId> m_map;
-};
-
-/**
- * \brief a thread-safe UsrMap
- */
-class GlobalUsrMap
-{
-public:
-
-  UsrMap clone();
-
   std::pair<SymbolId, bool> get(const std::string& usr);
 
-protected:
-  UsrMap& usrMap();
-  std::mutex& mutex();
+  size_t size() const;
 
 private:
-  UsrMap m_map;
-  std::mutex m_mutex;
+  std::unordered_map<std::string, SymbolId> m_map;
+  // the usr using each id; points to a key of m_map
+  std::unordered_map<int64_t, const std::string*> m_ids;
 };
 
 } // namespace csnap
@@ -4,25 +4,66 @@
 
 #include "filecontentcache.h"
 
-#include <stdexcept>
-#include <vector>
-
 namespace csnap
 {
 
+FileContentCache::FileContentCache() :
+  m_data(DefaultBudget)
+{
+
+}
+
 void FileContentCache::insert(std::shared_ptr<FileContent> item)
 {
-  m_data[item->file->id.value()] = item;
+  size_t bytes = memoryUsage(*item);
+  int64_t id = item->file->id.value();
+  m_data.insert(id, std::move(item), bytes);
 }
 
-std::shared_ptr<FileContent> FileContentCache::find(FileId itemid) const
+std::shared_ptr<FileContent> FileContentCache::find(FileId itemid)
 {
-  auto it = m_data.find(itemid.value());
+  return m_data.find(itemid.value());
+}
 
-  if (it != m_data.end())
-    return it->second.lock();
-  else
-    return nullptr;
+/**
+ * \brief returns the memory budget of the cache, in bytes
+ */
+size_t FileContentCache::budget() const
+{
+  return m_data.budget();
+}
+
+/**
+ * \brief sets the memory budget of the cache
+ * \param bytes  the budget in bytes
+ */
+void FileContentCache::setBudget(size_t bytes)
+{
+  m_data.setBudget(bytes);
+}
+
+/**
+ * \brief returns the number of file contents in the cache
+ */
+size_t FileContentCache::size() const
+{
+  return m_data.size();
+}
+
+/**
+ * \brief returns an estimate of the memory used by the file contents in the cache
+ */
+size_t FileContentCache::bytesUsed() const
+{
+  return m_data.bytesUsed();
+}
+
+/**
+ * \brief returns the hit, miss and eviction counters of the cache
+ */
+const CacheStats& FileContentCache::stats() const
+{
+  return m_data.stats();
 }
 
 void FileContentCache::clear()
@@ -30,15 +71,13 @@ void FileContentCache::clear()
   m_data.clear();
 }
 
-void FileContentCache::cleanup()
+/**
+ * \brief returns an estimate of the memory used by a file content
+ * \param fc  the file content
+ */
+size_t FileContentCache::memoryUsage(const FileContent& fc)
 {
-  for (auto it = m_data.begin(); it != m_data.end(); )
-  {
-    if (it->second.expired())
-      it = m_data.erase(it);
-    else
-      ++it;
-  }
+  return sizeof(FileContent) + fc.content.capacity() + fc.lines.capacity() * sizeof(std::string_view);
 }
 
 } // namespace csnap
@@ -4,40 +4,51 @@
 
 #include "filelist.h"
 
+#include "hash.h"
+
 #include <algorithm>
 #include <cassert>
+#include <stdexcept>
 
 namespace csnap
 {
 
+/**
+ * \brief adds a file to the list
+ * \param path  the path of the file
+ * 
+ * The file gets an id derived from \a path.
+ */
 File* FileList::add(std::string path)
 {
-  m_files.push_back(std::make_unique<File>());
-  m_files.back()->id = FileId((int)m_files.size() - 1);
-  m_files.back()->path = std::move(path);
-  return m_files.back().get();
+  auto f = std::make_unique<File>();
+  f->path = std::move(path);
+  return add(std::move(f));
 }
 
+/**
+ * \brief adds a file to the list
+ * \param f  the file
+ * 
+ * If the file has no id, it gets an id derived from its path.
+ * Otherwise, its id must not be used by another file of the list.
+ */
 File* FileList::add(std::unique_ptr<File> f)
 {
-  if(!f->id.valid())
-    f->id = FileId((int)m_files.size());
-
-  size_t i = (size_t)f->id.value();
-
-  if (i < m_files.size())
+  if (!f->id.valid())
   {
-    assert(m_files.at(i) == nullptr);
+    f->id = newId(f->path, [this](FileId id) {
+      return m_ids.find(id.value()) != m_ids.end();
+      });
   }
 
-  if (m_files.size() <= i)
-  {
-    m_files.resize(i + 1);
-  }
+  assert(m_ids.find(f->id.value()) == m_ids.end());
 
-  m_files[i] = std::move(f);
+  m_ids[f->id.value()] = f.get();
+  m_files.push_back(std::move(f));
+  index(*m_files.back());
 
-  return m_files[i].get();
+  return m_files.back().get();
 }
 
 std::vector<File*> FileList::all() const
@@ -54,24 +65,47 @@ std::vector<File*> FileList::all() const
 
 File* FileList::get(Identifier<File> id) const
 {
-  if (!id.valid())
-    return nullptr;
+  auto it = m_ids.find(id.value());
+  return it != m_ids.end() ? it->second : nullptr;
+}
 
-  size_t offset = (size_t)id.value();
+/**
+ * \brief computes the id of a new file
+ * \param path     the (canonical) path of the file
+ * \param is_used  a function returning whether an id is already used
+ * 
+ * The id is derived from \a path (see stable_id()).
+ * Throws std::runtime_error if the id is already used by another file.
+ */
+FileId FileList::newId(std::string_view path, const std::function<bool(FileId)>& is_used)
+{
+  FileId id{ stable_id(path) };
 
-  if (offset >= m_files.size())
-    return nullptr;
+  if (is_used(id))
+    throw std::runtime_error("file id collision for '" + std::string(path) + "'");
 
-  return m_files.at(offset).get();
+  return id;
 }
 
-File* FileList::find(const std::string& path) const
+/**
+ * \brief finds a file given its path
+ * \param path  the path of the file
+ * 
+ * The path is compared as is, no canonicalization is performed.
+ */
+File* FileList::find(std::string_view path) const
 {
-  auto it = std::find_if(m_files.begin(), m_files.end(), [&path](const FilePtr& f) {
-    return f && f->path == path;
-    });
+  auto it = m_index.find(path);
+  return it != m_index.end() ? get(it->second) : nullptr;
+}
+
+void FileList::index(const File& f)
+{
+  auto it = m_index.find(f.path);
 
-  return it != m_files.end() ? it->get() : nullptr;
+  // if several files share the same path, the first one is kept
+  if (it == m_index.end())
+    m_index.emplace(m_paths.store(f.path), f.id);
 }
 
 } // namespace csnap
@@ -0,0 +1,74 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#include "stringarena.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace csnap
+{
+
+/**
+ * \brief constructs an empty arena
+ * \param chunkSize  the size of the memory chunks allocated by the arena
+ * 
+ * Strings larger than \a chunkSize are stored in a chunk of their own.
+ */
+StringArena::StringArena(size_t chunkSize) :
+  m_chunk_size(chunkSize)
+{
+
+}
+
+/**
+ * \brief copies a string into the arena
+ * \param str  the string
+ * 
+ * The returned view is not null-terminated.
+ */
+std::string_view StringArena::store(std::string_view str)
+{
+  if (str.empty())
+    return std::string_view();
+
+  if (str.size() > m_remaining)
+  {
+    size_t n = std::max(m_chunk_size, str.size());
+    m_chunks.push_back(std::make_unique<char[]>(n));
+    m_cursor = m_chunks.back().get();
+    m_remaining = n;
+  }
+
+  char* dest = m_cursor;
+  std::memcpy(dest, str.data(), str.size());
+  m_cursor += str.size();
+  m_remaining -= str.size();
+  m_bytes_used += str.size();
+
+  return std::string_view(dest, str.size());
+}
+
+/**
+ * \brief returns the total size of the strings stored in the arena
+ */
+size_t StringArena::bytesUsed() const
+{
+  return m_bytes_used;
+}
+
+/**
+ * \brief releases all the memory of the arena
+ * 
+ * All string views previously returned by store() are invalidated.
+ */
+void StringArena::clear()
+{
+  m_chunks.clear();
+  m_cursor = nullptr;
+  m_remaining = 0;
+  m_bytes_used = 0;
+}
+
+} // namespace csnap
@@ -4,25 +4,66 @@
 
 #include "symbolcache.h"
 
-#include <stdexcept>
-#include <vector>
-
 namespace csnap
 {
 
+SymbolCache::SymbolCache() :
+  m_data(DefaultBudget)
+{
+
+}
+
 void SymbolCache::insert(std::shared_ptr<Symbol> s)
 {
-  m_data[s->id.value()] = s;
+  size_t bytes = memoryUsage(*s);
+  int64_t id = s->id.value();
+  m_data.insert(id, std::move(s), bytes);
 }
 
-std::shared_ptr<Symbol> SymbolCache::find(SymbolId symid) const
+std::shared_ptr<Symbol> SymbolCache::find(SymbolId symid)
 {
-  auto it = m_data.find(symid.value());
+  return m_data.find(symid.value());
+}
 
-  if (it != m_data.end())
-    return it->second.lock();
-  else
-    return nullptr;
+/**
+ * \brief returns the memory budget of the cache, in bytes
+ */
+size_t SymbolCache::budget() const
+{
+  return m_data.budget();
+}
+
+/**
+ * \brief sets the memory budget of the cache
+ * \param bytes  the budget in bytes
+ */
+void SymbolCache::setBudget(size_t bytes)
+{
+  m_data.setBudget(bytes);
+}
+
+/**
+ * \brief returns the number of symbols in the cache
+ */
+size_t SymbolCache::size() const
+{
+  return m_data.size();
+}
+
+/**
+ * \brief returns an estimate of the memory used by the symbols in the cache
+ */
+size_t SymbolCache::bytesUsed() const
+{
+  return m_data.bytesUsed();
+}
+
+/**
+ * \brief returns the hit, miss and eviction counters of the cache
+ */
+const CacheStats& SymbolCache::stats() const
+{
+  return m_data.stats();
 }
 
 void SymbolCache::clear()
@@ -30,15 +71,13 @@ void SymbolCache::clear()
   m_data.clear();
 }
 
-void SymbolCache::cleanup()
+/**
+ * \brief returns an estimate of the memory used by a symbol
+ * \param s  the symbol
+ */
+size_t SymbolCache::memoryUsage(const Symbol& s)
 {
-  for (auto it = m_data.begin(); it != m_data.end(); )
-  {
-    if (it->second.expired())
-      it = m_data.erase(it);
-    else
-      ++it;
-  }
+  return sizeof(Symbol) + s.name.capacity() + s.usr.capacity() + s.display_name.capacity();
 }
 
 } // namespace csnap
@@ -0,0 +1,97 @@
+// Copyright (C) 2023 Vincent Chambrin
+// This file is part of the 'csnap' project.
+// For conditions of distribution and use, see copyright notice in LICENSE.
+
+#include "symboltable.h"
+
+#include <stdexcept>
+
+namespace csnap
+{
+
+/**
+ * \brief constructs an empty table
+ */
+SymbolTable::SymbolTable() :
+  m_strings(1024 * 1024)
+{
+
+}
+
+/**
+ * \brief adds a symbol to the table
+ * \param s  the symbol
+ */
+void SymbolTable::add(const Symbol& s)
+{
+  add(s.id, s.kind, s.flags, s.parent_id, s.name, s.usr, s.display_name);
+}
+
+/**
+ * \brief adds a symbol to the table
+ * \param id           the id of the symbol
+ * \param kind         the kind of symbol
+ * \param flags        the flags of the symbol
+ * \param parent       the id of the parent symbol
+ * \param name         the name of the symbol
+ * \param usr          the usr of the symbol
+ * \param displayname  the display name of the symbol
+ * 
+ * The strings are copied into the table.
+ * If a symbol with the same id is already in the table, it is replaced.
+ */
+void SymbolTable::add(SymbolId id, Whatsit kind, int flags, SymbolId parent, std::string_view name, std::string_view usr, std::string_view displayname)
+{
+  if (id.value() < 0)
+    throw std::invalid_argument("SymbolTable::add(): invalid symbol id");
+
+  auto [it, inserted] = m_rows.try_emplace(id.value(), m_kinds.size());
+
+  if (!inserted)
+  {
+    size_t r = it->second;
+    m_kinds[r] = kind;
+    m_flags[r] = flags;
+    m_parents[r] = parent;
+    m_names[r] = m_strings.store(name);
+    m_usrs[r] = m_strings.store(usr);
+    m_display_names[r] = m_strings.store(displayname);
+    return;
+  }
+
+  m_kinds.push_back(kind);
+  m_flags.push_back(flags);
+  m_parents.push_back(parent);
+  m_names.push_back(m_strings.store(name));
+  m_usrs.push_back(m_strings.store(usr));
+  m_display_names.push_back(m_strings.store(displayname));
+}
+
+/**
+ * \brief returns the number of symbols in the table
+ */
+size_t SymbolTable::size() const
+{
+  return m_kinds.size();
+}
+
+/**
+ * \brief returns a copy of a symbol
+ * \param id  the id of the symbol
+ */
+Symbol SymbolTable::get(SymbolId id) const
+{
+  size_t r = row(id);
+
+  Symbol s;
+  s.id = id;
+  s.kind = m_kinds[r];
+  s.flags = m_flags[r];
+  s.parent_id = m_parents[r];
+  s.name = std::string(m_names[r]);
+  s.usr = std::string(m_usrs[r]);
+  s.display_name = std::string(m_display_names[r]);
+  return s;
+}
+
+} // namespace csnap
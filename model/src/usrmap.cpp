@@ -4,6 +4,11 @@
 
 #include "usrmap.h"
 
+#include "hash.h"
+
+#include <cstdint>
+#include <stdexcept>
+
 namespace csnap
 {
 
@@ -23,13 +28,14 @@ SymbolId UsrMap::find(const std::string& usr) const
  * \brief inserts a new usr into the map
  * \param usr
  * 
- * This function assigns an unused id to \a usr and returns the id.
+ * This function assigns the id derived from \a usr (see stable_id()) 
+ * and returns the id.
  */
 SymbolId UsrMap::insert(const std::string& usr)
 {
-  SymbolId new_id{ (int)m_map.size() };
-  insert(usr, new_id);
-  return new_id;
+  SymbolId id{ stable_id(usr) };
+  insert(usr, id);
+  return id;
 }
 
 /**
@@ -37,56 +43,44 @@ SymbolId UsrMap::insert(const std::string& usr)
  * \param usr  the usr
  * \param id   the id to assign to the usr
  * 
- * Note that this function currently does not verify whether \a usr is already 
- * in the map or if \a id is already associated with another usr.
+ * This is also used to load the ids of an existing snapshot.
+ * Throws std::runtime_error if \a id is already associated with another usr.
  */
 void UsrMap::insert(const std::string& usr, SymbolId id)
 {
-  m_map[usr] = id;
-}
-
-/**
- * \brief returns a copy of this usr map
- */
-UsrMap GlobalUsrMap::clone()
-{
-  UsrMap copy;
+  auto used = m_ids.find(id.value());
 
-  {
-    std::lock_guard lock{ mutex() };
-    copy = usrMap();
-  }
+  if (used != m_ids.end() && *used->second != usr)
+    throw std::runtime_error("symbol id collision between '" + *used->second + "' and '" + usr + "'");
 
-  return copy;
+  auto it = m_map.insert_or_assign(usr, id).first;
+  m_ids[id.value()] = &it->first;
 }
 
 /**
  * \brief get a symbol id from a usr
  * \param usr  the usr
  * 
+ * If \a usr isn't in the map, it is inserted with the id derived from it.
  * This function returns a pair with the symbol id and a boolean indicating 
- * whether the usr was inserted into the map (true if inserted; false if already present).
+ * whether the usr was inserted into the map.
  */
-std::pair<SymbolId, bool> GlobalUsrMap::get(const std::string& usr)
+std::pair<SymbolId, bool> UsrMap::get(const std::string& usr)
 {
-  std::lock_guard lock{ mutex() };
-
-  SymbolId id = usrMap().find(usr);
+  auto it = m_map.find(usr);
 
-  if (id.valid())
-    return { id, false };
+  if (it != m_map.end())
+    return { it->second, false };
 
-  return { usrMap().insert(usr), true };
+  return { insert(usr), true };
 }
 
-UsrMap& GlobalUsrMap::usrMap()
-{
-  return m_map;
-}
-
-std::mutex& GlobalUsrMap::mutex()
+/**
+ * \brief returns the number of usrs in the map
+ */
+size_t UsrMap::size() const
 {
-  return m_mutex;
+  return m_map.size();
 }
 
 } // namespace csnap
@@ -14,6 +14,18 @@
 #include <string>
 #include <vector>
 
+/**
+ * \brief returns the path of the csnap executable
+ * 
+ * The path is set by main() from the first command line argument; 
+ * it is used to start worker processes.
+ */
+inline std::string& program_path()
+{
+  static std::string path;
+  return path;
+}
+
 inline std::string read_arg_val(std::vector<std::string>& args, std::vector<std::string>::iterator it)
 {
   if (std::next(it) == args.end())
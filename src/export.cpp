@@ -3,6 +3,7 @@
 
 #include "csnap/exporter/exporter.h"
 
+#include <algorithm>
 #include <iostream>
 
 namespace
@@ -28,6 +29,51 @@ std::filesystem::path output(std::vector<std::string>& args)
   return r;
 }
 
+std::filesystem::path archive(std::vector<std::string>& args)
+{
+  std::string path = read_arg(args, { "--archive" });
+
+  std::filesystem::path r{ path };
+  return r;
+}
+
+bool full(std::vector<std::string>& args)
+{
+  return read_optional_flag(args, { "--full" });
+}
+
+int cache_mb(std::vector<std::string>& args)
+{
+  std::string num = read_arg(args, { "--cache-mb" });
+  return std::stoi(num);
+}
+
+int symbol_shards(std::vector<std::string>& args)
+{
+  std::string num = read_arg(args, { "--symbol-shards" });
+  return std::stoi(num);
+}
+
+int threads(std::vector<std::string>& args)
+{
+  std::string num = read_arg(args, { "--threads" });
+  return std::stoi(num);
+}
+
+template<typename F>
+bool do_try(F&& func)
+{
+  try
+  {
+    func();
+    return true;
+  }
+  catch (...)
+  {
+    return false;
+  }
+}
+
 } // namespace
 
 void export_(std::vector<std::string> args)
@@ -38,10 +84,19 @@ void export_(std::vector<std::string> args)
 
   auto snapshot = Snapshot::open(snapshot_path);
 
+  // the exporter threads open their own read-only connections
+  snapshot.upgrade();
+
   SnapshotExporter exporter{ snapshot };
-  exporter.outputdir = output(args);
 
-  if (!std::filesystem::exists(exporter.outputdir))
+  if (!do_try([&exporter, &args]() { exporter.archive = archive(args); }))
+    exporter.outputdir = output(args);
+  do_try([&exporter, &args]() { exporter.nb_threads = std::max(threads(args), 1); });
+  do_try([&exporter, &args]() { exporter.cache_size = size_t(std::max(cache_mb(args), 1)) * 1024 * 1024; });
+  exporter.incremental = !full(args);
+  do_try([&exporter, &args]() { exporter.symbol_shard_depth = std::clamp(symbol_shards(args), 0, 8); });
+
+  if (exporter.archive.empty() && !std::filesystem::exists(exporter.outputdir))
     std::filesystem::create_directories(exporter.outputdir);
 
   if (!args.empty())
@@ -58,4 +113,14 @@ void export_(std::vector<std::string> args)
   }
 
   exporter.run();
+
+  Database::StatementCacheStats stats = snapshot.database().statementCacheStats();
+  std::cout << "sql statement cache: " << stats.hits << " hits, " << stats.misses << " misses" << std::endl;
+
+  auto print_cache_stats = [](const char* name, const CacheStats& s) {
+    std::cout << name << ": " << s.hits << " hits, " << s.misses << " misses, " << s.evictions << " evictions" << std::endl;
+  };
+
+  print_cache_stats("symbol cache", snapshot.symbolCache().stats());
+  print_cache_stats("file content cache", snapshot.fileContentCache().stats());
 }
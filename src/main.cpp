@@ -1,4 +1,6 @@
 
+#include "cli.h"
+
 #include "csnap/model/version.h"
 
 #include <iostream>
@@ -6,7 +8,9 @@
 #include <vector>
 
 extern void scan(std::vector<std::string> args);
+extern void merge(std::vector<std::string> args);
 extern void export_(std::vector<std::string> args);
+extern void worker(std::vector<std::string> args);
 
 [[noreturn]] void version()
 {
@@ -19,8 +23,10 @@ extern void export_(std::vector<std::string> args);
   std::cout << "csnap is a libclang-based command-line utility to create snapshots of C++ programs." << std::endl;
   std::cout << std::endl;
   std::cout << "Syntax:" << std::endl;
-  std::cout << "  csnap scan --sln <Visual Studio solution> --output <snapshot.db>" << std::endl;
-  std::cout << "  csnap export -i <snapshot.db> --output <outdir>" << std::endl;
+  std::cout << "  csnap scan --sln <Visual Studio solution> --output <snapshot.db> [--shard <i>/<N>] [--workers <N>] [--worker-timeout <seconds>]" << std::endl;
+  std::cout << "  csnap scan --update <snapshot.db>" << std::endl;
+  std::cout << "  csnap merge <snapshot.db>... --output <merged.db>" << std::endl;
+  std::cout << "  csnap export -i <snapshot.db> (--output <outdir> | --archive <out.tar>) [--threads <N>] [--cache-mb <N>] [--symbol-shards <N>] [--full]" << std::endl;
 
   std::exit(0);
 }
@@ -29,6 +35,8 @@ int main(int argc, char* argv[])
 {
   auto args = std::vector<std::string>(argv, argv + argc);
 
+  program_path() = args.front();
+
   if (args.size() < 2 || args.at(1) == "--help" || args.at(1) == "-h")
     help();
   else if (args.at(1) == "--version" || args.at(1) == "-v")
@@ -39,11 +47,21 @@ int main(int argc, char* argv[])
     args.erase(args.begin(), args.begin() + 2);
     scan(args);
   }
+  else if (args.at(1) == "merge")
+  {
+    args.erase(args.begin(), args.begin() + 2);
+    merge(args);
+  }
   else  if (args.at(1) == "export")
   {
     args.erase(args.begin(), args.begin() + 2);
     export_(args);
   }
+  else if (args.at(1) == "worker")
+  {
+    args.erase(args.begin(), args.begin() + 2);
+    worker(args);
+  }
   else
   {
     std::cerr << "unrecognized command " << args.at(1) << std::endl;
@@ -0,0 +1,103 @@
+
+#include "cli.h"
+
+#include "csnap/indexer/merger.h"
+
+#include "csnap/database/snapshot.h"
+
+#include <iostream>
+
+namespace
+{
+
+std::filesystem::path output(std::vector<std::string>& args)
+{
+  std::string path = read_arg(args, { "-o", "--output" });
+
+  std::filesystem::path r{ path };
+  return r;
+}
+
+bool overwrite(std::vector<std::string>& args)
+{
+  return read_optional_flag(args, { "--overwrite" });
+}
+
+std::vector<std::filesystem::path> inputs(std::vector<std::string>& args)
+{
+  std::vector<std::filesystem::path> r;
+
+  for (auto it = args.begin(); it != args.end(); )
+  {
+    if (it->rfind("-", 0) == 0)
+    {
+      ++it;
+      continue;
+    }
+
+    std::filesystem::path p{ *it };
+
+    if (!std::filesystem::exists(p))
+      throw std::runtime_error("input snapshot does not exist: " + *it);
+
+    r.push_back(p);
+    it = args.erase(it);
+  }
+
+  if (r.empty())
+    throw std::runtime_error("no input snapshot");
+
+  return r;
+}
+
+} // namespace
+
+void merge(std::vector<std::string> args)
+{
+  using namespace csnap;
+
+  std::filesystem::path dbpath = output(args);
+  bool should_overwrite = overwrite(args);
+  std::vector<std::filesystem::path> snapshots = inputs(args);
+
+  if (!args.empty())
+  {
+    std::cerr << "unrecognized command line args: ";
+
+    std::for_each(args.begin(), args.end(), [](const std::string& a) {
+      std::cerr << a << " ";
+      });
+
+    std::cerr << std::endl;
+    std::exit(1);
+  }
+
+  if (std::filesystem::exists(dbpath))
+  {
+    if (should_overwrite)
+    {
+      std::filesystem::remove(dbpath);
+    }
+    else
+    {
+      std::cerr << "output file already exists" << std::endl;
+      std::exit(1);
+    }
+  }
+
+  Snapshot output = Snapshot::create(dbpath);
+  output.beginBulkLoad();
+
+  SnapshotMerger merger{ output };
+
+  for (const std::filesystem::path& p : snapshots)
+  {
+    std::cout << "merging " << p.u8string() << std::endl;
+
+    Snapshot input = Snapshot::open(p);
+    merger.merge(input);
+  }
+
+  output.createIndexes();
+  output.endBulkLoad();
+}
@@ -4,13 +4,11 @@
 #include "csnap/indexer/scanner.h"
 
 #include <iostream>
+#include <tuple>
+#include <utility>
 
-std::filesystem::path input(std::vector<std::string>& args)
+std::filesystem::path check_sln(std::filesystem::path r)
 {
-  std::string path = read_arg(args, { "-i", "--input", "--sln" });
-  
-  std::filesystem::path r{ path };
-
   if (!std::filesystem::exists(r))
     throw std::runtime_error("input file does not exist");
 
@@ -20,6 +18,12 @@ std::filesystem::path input(std::vector<std::string>& args)
   return r;
 }
 
+std::filesystem::path input(std::vector<std::string>& args)
+{
+  std::string path = read_arg(args, { "-i", "--input", "--sln" });
+  return check_sln(std::filesystem::path(path));
+}
+
 std::filesystem::path output(std::vector<std::string>& args)
 {
   std::string path = read_arg(args, { "-o", "--output" });
@@ -28,6 +32,18 @@ std::filesystem::path output(std::vector<std::string>& args)
   return r;
 }
 
+std::filesystem::path update(std::vector<std::string>& args)
+{
+  std::string path = read_arg(args, { "--update" });
+
+  std::filesystem::path r{ path };
+
+  if (!std::filesystem::exists(r))
+    throw std::runtime_error("snapshot to update does not exist");
+
+  return r;
+}
+
 bool overwrite(std::vector<std::string>& args)
 {
   return read_optional_flag(args, { "--overwrite" });
@@ -44,6 +60,50 @@ int threads(std::vector<std::string>& args)
   return std::stoi(num);
 }
 
+int index_threads(std::vector<std::string>& args)
+{
+  std::string num = read_arg(args, { "--index-threads" });
+  return std::stoi(num);
+}
+
+int queue_depth(std::vector<std::string>& args)
+{
+  std::string num = read_arg(args, { "--queue-depth" });
+  return std::stoi(num);
+}
+
+int workers(std::vector<std::string>& args)
+{
+  std::string num = read_arg(args, { "--workers" });
+  return std::stoi(num);
+}
+
+int worker_timeout(std::vector<std::string>& args)
+{
+  std::string num = read_arg(args, { "--worker-timeout" });
+  return std::stoi(num);
+}
+
+/**
+ * \brief parses the --shard option, of the form <i>/<N> with 0 <= i < N
+ */
+std::pair<int, int> shard(std::vector<std::string>& args)
+{
+  std::string spec = read_arg(args, { "--shard" });
+  size_t sep = spec.find('/');
+
+  if (sep == std::string::npos)
+    throw std::runtime_error("invalid shard, expected <i>/<N>: " + spec);
+
+  int i = std::stoi(spec.substr(0, sep));
+  int n = std::stoi(spec.substr(sep + 1));
+
+  if (n < 1 || i < 0 || i >= n)
+    throw std::runtime_error("invalid shard, expected 0 <= i < N: " + spec);
+
+  return { i, n };
+}
+
 template<typename F>
 bool do_try(F&& func)
 {
@@ -58,18 +118,8 @@ bool do_try(F&& func)
   }
 }
 
-void scan(std::vector<std::string> args)
+void check_no_remaining_args(const std::vector<std::string>& args)
 {
-  using namespace csnap;
-
-  Scanner scanner;
-  scanner.save_ast = save_ast(args);
-  do_try([&scanner, &args]() { scanner.nb_parsing_threads = threads(args); });
-
-  std::filesystem::path dbpath = output(args);
-  std::filesystem::path slnpath = input(args);
-  bool should_overwrite = overwrite(args);
-
   if (!args.empty())
   {
     std::cerr << "unrecognized command line args: ";
@@ -81,6 +131,64 @@ void scan(std::vector<std::string> args)
     std::cerr << std::endl;
     std::exit(1);
   }
+}
+
+void scan_update(csnap::Scanner& scanner, std::vector<std::string>& args)
+{
+  using namespace csnap;
+
+  std::filesystem::path dbpath = update(args);
+  std::filesystem::path slnpath;
+
+  auto has_option = [&args](const char* name) {
+    return std::find(args.begin(), args.end(), name) != args.end();
+  };
+
+  if (has_option("-i") || has_option("--input") || has_option("--sln"))
+    slnpath = input(args);
+
+  check_no_remaining_args(args);
+
+  scanner.openSnapshot(dbpath);
+
+  if (slnpath.empty())
+  {
+    // use the solution that was used to create the snapshot
+    slnpath = check_sln(std::filesystem::u8path(scanner.snapshot().property("sln.path")));
+  }
+
+  scanner.scanSln(slnpath);
+}
+
+void scan(std::vector<std::string> args)
+{
+  using namespace csnap;
+
+  Scanner scanner;
+  scanner.save_ast = save_ast(args);
+  do_try([&scanner, &args]() { scanner.nb_parsing_threads = threads(args); });
+  do_try([&scanner, &args]() { scanner.nb_indexing_threads = index_threads(args); });
+  do_try([&scanner, &args]() { scanner.parsing_queue_depth = queue_depth(args); });
+  do_try([&scanner, &args]() { scanner.nb_workers = workers(args); });
+  do_try([&scanner, &args]() { scanner.worker_timeout = worker_timeout(args); });
+  scanner.worker_program = std::filesystem::u8path(program_path());
+
+  if (std::find(args.begin(), args.end(), std::string("--shard")) != args.end())
+  {
+    std::tie(scanner.shard_index, scanner.shard_count) = shard(args);
+  }
+
+  if (std::find(args.begin(), args.end(), std::string("--update")) != args.end())
+  {
+    scan_update(scanner, args);
+    return;
+  }
+
+  std::filesystem::path dbpath = output(args);
+  std::filesystem::path slnpath = input(args);
+  bool should_overwrite = overwrite(args);
+
+  check_no_remaining_args(args);
 
   if (std::filesystem::exists(dbpath))
   {
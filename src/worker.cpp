@@ -0,0 +1,60 @@
+
+#include "cli.h"
+
+#include "csnap/indexer/worker.h"
+
+#include "csnap/database/snapshot.h"
+
+#include <iostream>
+
+namespace
+{
+
+std::filesystem::path snapshot_path(std::vector<std::string>& args)
+{
+  std::filesystem::path p{ read_arg(args, { "--snapshot" }) };
+
+  if (!std::filesystem::exists(p))
+    throw std::runtime_error("snapshot does not exist");
+
+  return p;
+}
+
+bool save_ast(std::vector<std::string>& args)
+{
+  return read_optional_flag(args, { "--save-ast" });
+}
+
+} // namespace
+
+/**
+ * \brief runs a worker process for "csnap scan --workers"
+ * 
+ * This command is not meant to be used directly: it is started by 
+ * WorkerPool, which communicates with the worker through its standard 
+ * input and output.
+ */
+void worker(std::vector<std::string> args)
+{
+  using namespace csnap;
+
+  std::filesystem::path dbpath = snapshot_path(args);
+  bool should_save_ast = save_ast(args);
+
+  if (!args.empty())
+    throw std::runtime_error("unrecognized command line args");
+
+  Database db;
+
+  if (!db.open(dbpath))
+    throw std::runtime_error("could not open snapshot");
+
+  // the process that started the worker writes into the snapshot
+  db.setBusyTimeout(std::chrono::minutes(1));
+
+  Snapshot snapshot{ std::move(db) };
+
+  Worker w{ snapshot };
+  w.save_ast = should_save_ast;
+  w.run();
+}